@@ -0,0 +1,12 @@
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofApp.h"
+
+
+int main()
+{
+  // no window and no sensor, the timings go to the console
+  ofAppNoWindow window;
+  ofSetupOpenGL( &window, 0, 0, OF_WINDOW );
+  ofRunApp( new ofApp() );
+}
@@ -0,0 +1,455 @@
+#include "ofApp.h"
+
+using namespace ofxKinect2;
+
+namespace
+{
+  // mean microseconds per call over _iterations, after one warm up call
+  template< class Function >
+  double measure( int _iterations, Function _function )
+  {
+    _function();
+
+    unsigned long long start = ofGetElapsedTimeMicros();
+    for( int i = 0; i < _iterations; ++i ) _function();
+    return ( ofGetElapsedTimeMicros() - start ) / ( double )_iterations;
+  }
+
+  float gaussian( float _sigma )
+  {
+    float u = ofRandom( 1e-6f, 1.f );
+    float v = ofRandom( 1.f );
+    return _sigma * sqrt( -2.f * log( u ) ) * cos( TWO_PI * v );
+  }
+
+  // MockReader
+  //   stands in for a 16 bit SDK reader: one frame buffer, handed out again only
+  //   after the previous frame is released, a new frame is always waiting
+  //------------------------------------------------------------
+  class MockReader;
+
+  class MockFrame : public IUnknown
+  {
+  public:
+    MockFrame( MockReader& _reader ) : reader( _reader ) {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface( REFIID, void** _pp ){ *_pp = nullptr; return E_NOINTERFACE; }
+    ULONG STDMETHODCALLTYPE   AddRef(){ return 1; }
+    ULONG STDMETHODCALLTYPE   Release();
+
+    HRESULT get_RelativeTime( INT64* _p_time );
+    HRESULT AccessUnderlyingBuffer( UINT* _p_size, UINT16** _pp_buffer );
+
+  private:
+    MockReader& reader;
+  };
+
+  class MockReader : public IUnknown
+  {
+    friend class MockFrame;
+
+  public:
+    MockReader( int _width, int _height )
+      : width( _width )
+      , height( _height )
+      , buffer( _width * _height )
+      , frame( *this )
+      , timestamp( 0 )
+      , is_held( false )
+    {
+      for( auto& v : buffer ) v = ( unsigned short )ofRandom( 500, 4500 );
+    }
+
+    HRESULT AcquireLatestFrame( MockFrame** _pp_frame )
+    {
+      *_pp_frame = nullptr;
+      if( is_held ) return E_PENDING;
+
+      is_held     = true;
+      timestamp  += 333333;
+      *_pp_frame  = &frame;
+      return S_OK;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+  private:
+    int                      width, height;
+    vector< unsigned short > buffer;
+    MockFrame                frame;
+    INT64                    timestamp;
+    bool                     is_held;
+  };
+
+  ULONG MockFrame::Release()
+  {
+    reader.is_held = false;
+    return 0;
+  }
+
+  HRESULT MockFrame::get_RelativeTime( INT64* _p_time )
+  {
+    *_p_time = reader.timestamp;
+    return S_OK;
+  }
+
+  HRESULT MockFrame::AccessUnderlyingBuffer( UINT* _p_size, UINT16** _pp_buffer )
+  {
+    *_p_size    = ( UINT )reader.buffer.size();
+    *_pp_buffer = reader.buffer.data();
+    return S_OK;
+  }
+
+  // open() is compiled but never called, the stream is set up by hand
+  struct MockSource : IUnknown
+  {
+    HRESULT OpenReader( MockReader** _pp_reader ){ *_pp_reader = nullptr; return E_NOTIMPL; }
+  };
+
+  struct MockTraits : ZeroCopySensorTraits< MockSource, MockReader, MockFrame, IUnknown >
+  {
+    static const char* getName() { return "MockStream"; }
+    static HRESULT     getSource( IKinectSensor*, Source** _pp_source ) { *_pp_source = nullptr; return E_NOTIMPL; }
+    static HRESULT     getFrameDescription( Source*, IFrameDescription** _pp_description ) { *_pp_description = nullptr; return S_OK; }
+
+    static HRESULT     subscribeFrameArrived( Reader*, WAITABLE_HANDLE* _p_event ) { *_p_event = 0; return S_OK; }
+    static void        unsubscribeFrameArrived( Reader*, WAITABLE_HANDLE ) {}
+    static bool        isFrameArrived( Reader*, WAITABLE_HANDLE ) { return true; }
+
+    // one stream at a time, set by MockStream::setup()
+    static Reader*&    getReader( StreamHandle& ) { static Reader* p_reader = nullptr; return p_reader; }
+  };
+
+  // MockStream
+  //   StreamT over MockTraits, setPixels() copies GRAY16 like DepthStream does
+  //------------------------------------------------------------
+  class MockStream : public StreamT< MockStream, MockTraits >
+  {
+    friend class StreamT< MockStream, MockTraits >;
+
+  public:
+    // what Stream::setup() and open() fill in, without a device
+    void setup( MockReader& _reader )
+    {
+      MockTraits::getReader( stream ) = &_reader;
+      frame.sensor_type       = SENSOR_DEPTH;
+      frame.frame_index       = 0;
+      frame.stride            = 0;
+      frame.data              = nullptr;
+      frame.data_size         = 0;
+      frame.width             = _reader.getWidth();
+      frame.height            = _reader.getHeight();
+      frame.mode.pixel_format = PIXEL_FORMAT_GRAY16;
+      downscale               = 1;
+      is_zero_copy            = false;
+      frame_arrived           = 0;
+      is_frame_pending        = false;
+    }
+
+    ~MockStream()
+    {
+      std::atomic_store( &frame_handle, FrameHandle::Ref() );
+      MockTraits::getReader( stream ) = nullptr;
+    }
+
+    bool read() { return readFrame(); }
+
+    const ofShortPixels& getPixels() const { return pix; }
+
+  protected:
+    bool isPixelFormatSupported( PixelFormat _format ) const { return _format == PIXEL_FORMAT_GRAY16; }
+
+    void setPixels( const Frame& _frame )
+    {
+      Stream::updateTimestamp( _frame );
+      if( isPixelsFromHandle() ) return;
+
+      pix.allocate( _frame.width, _frame.height, 1 );
+      convertShort( ( const unsigned short* )_frame.data, pix.getData(), _frame.width, _frame.height, 1, false );
+    }
+
+    ofShortPixels pix;
+  };
+}
+
+//--------------------------------------------------------------
+void ofApp::setup()
+{
+  ofSeedRandom( 0 );
+
+  benchmarkMarkers();
+  benchmarkJointFilters();
+  benchmarkSkeletonRenderer();
+  benchmarkColorConversion();
+  benchmarkStreamRead();
+}
+
+//--------------------------------------------------------------
+void ofApp::update()
+{
+  ofExit();
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkMarkers()
+{
+  const int width  = 512;
+  const int height = 424;
+  const int cols   = 16;
+  const int rows   = 8;
+  const int cell_w = width / cols;
+  const int cell_h = height / rows;
+
+  vector< unsigned short > ir( width * height );
+  vector< unsigned short > depth( width * height, 1500 );
+
+  const int counts[] = { 8, 32, 128 };
+  for( int count : counts )
+  {
+    // ir background noise and gaussian spots at sub-pixel positions, one per grid cell
+    for( auto& v : ir ) v = ( unsigned short )ofRandom( 500, 3000 );
+
+    vector< ofVec2f > truth;
+    for( int m = 0; m < count; ++m )
+    {
+      ofVec2f p( ( m % cols ) * cell_w + ofRandom( 8, cell_w - 8 ), ( m / cols ) * cell_h + ofRandom( 8, cell_h - 8 ) );
+      truth.push_back( p );
+
+      for( int y = ( int )p.y - 4; y <= ( int )p.y + 4; ++y )
+      {
+        for( int x = ( int )p.x - 4; x <= ( int )p.x + 4; ++x )
+        {
+          float           d2 = ofVec2f( x, y ).squareDistance( p );
+          unsigned short& v  = ir[ y * width + x ];
+          v = ( unsigned short )min( v + 45000.f * exp( -d2 / ( 2 * 1.2f * 1.2f ) ), 65535.f );
+        }
+      }
+    }
+
+    MarkerDetector detector;
+    double         micros = measure( 200, [ & ](){ detector.update( ir.data(), width, height, depth.data(), 0 ); } );
+
+    // nearest detection per spot
+    const vector< Marker >& markers = detector.getMarkers();
+    float                   error   = 0;
+    int                     found   = 0;
+    for( auto& t : truth )
+    {
+      float best = numeric_limits< float >::max();
+      for( auto& m : markers ) best = min( best, m.position.distance( t ) );
+      if( best < 2 )
+      {
+        error += best;
+        ++found;
+      }
+    }
+
+    ofLogNotice( "MarkerDetector" ) << count << " markers: " << micros << " us / frame, found " << found
+                                    << ", mean centroid error " << ( found ? error / found : 0 ) << " px";
+  }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkJointFilters()
+{
+  // every joint of six bodies on its own smooth path, 30 fps with 1 cm of noise
+  const int   num_joints = BODY_COUNT * JointType_Count;
+  const int   num_frames = 900;
+  const float dt         = 1.f / 30.f;
+  const float noise      = 0.01f;
+
+  vector< ofVec3f > truth( num_frames * num_joints ), input( num_frames * num_joints );
+  for( int j = 0; j < num_joints; ++j )
+  {
+    float phase = ofRandom( TWO_PI );
+    float speed = ofRandom( 0.5f, 2.f );
+    for( int f = 0; f < num_frames; ++f )
+    {
+      float   t = f * dt * speed + phase;
+      ofVec3f p( 0.4f * sin( t ), 0.3f * sin( 2 * t ), 2 + 0.2f * cos( t ) );
+      truth[ f * num_joints + j ] = p;
+      input[ f * num_joints + j ] = p + ofVec3f( gaussian( noise ), gaussian( noise ), gaussian( noise ) );
+    }
+  }
+
+  const JointFilterType types[] = { JOINT_FILTER_NONE, JOINT_FILTER_DOUBLE_EXPONENTIAL, JOINT_FILTER_ONE_EURO };
+  const char*           names[] = { "none", "double exponential", "one euro" };
+  for( int k = 0; k < 3; ++k )
+  {
+    JointFilter< num_joints > filter;
+    filter.setType( types[ k ] );
+
+    vector< ofVec3f > output( num_frames * num_joints );
+    int               frame  = 0;
+    double            micros = measure( num_frames - 1, [ & ]()
+    {
+      const ofVec3f* in = &input[ frame * num_joints ];
+      for( int j = 0; j < num_joints; ++j ) filter.set( j, in[ j ].x, in[ j ].y, in[ j ].z, true );
+      filter.apply( dt );
+
+      ofVec3f* out = &output[ frame * num_joints ];
+      for( int j = 0; j < num_joints; ++j ) out[ j ].set( filter.get( j, 0 ), filter.get( j, 1 ), filter.get( j, 2 ) );
+      ++frame;
+    } );
+
+    // error against the path, and the delay in frames that fits the output best
+    float error = 0, best_error = numeric_limits< float >::max();
+    int   lag   = 0;
+    for( int s = 0; s <= 10; ++s )
+    {
+      float sum = 0;
+      int   n   = 0;
+      for( int f = 30 + s; f < num_frames; ++f )
+      {
+        for( int j = 0; j < num_joints; ++j, ++n ) sum += output[ f * num_joints + j ].squareDistance( truth[ ( f - s ) * num_joints + j ] );
+      }
+      float rms = sqrt( sum / n );
+      if( s == 0 ) error = rms;
+      if( rms < best_error )
+      {
+        best_error = rms;
+        lag        = s;
+      }
+    }
+
+    ofLogNotice( "JointFilter" ) << names[ k ] << ": " << micros << " us / frame of " << num_joints << " joints, rms error "
+                                 << error * 1000 << " mm, lag " << lag * dt * 1000 << " ms";
+  }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkSkeletonRenderer()
+{
+  // six bodies spread over the color frame, a few joints inferred or lost like a real frame
+  BodyFrame frame;
+  for( int i = 0; i < BODY_COUNT; ++i )
+  {
+    Body&   body = frame.bodies[ i ];
+    ofPoint center( 160 + i * 320, 540 );
+
+    body.setId( i + 1 );
+    body.setTracked( true );
+    body.setHandStates( HandState_Open, HandState_Closed );
+    body.setLean( ofVec2f( ofRandom( -20, 20 ), ofRandom( -20, 20 ) ), TrackingState_Tracked );
+
+    for( int j = 0; j < JointType_Count; ++j )
+    {
+      float r = ofRandom( 1 );
+
+      Joint joint;
+      joint.JointType     = ( JointType )j;
+      joint.TrackingState = r < 0.8f ? TrackingState_Tracked : ( r < 0.95f ? TrackingState_Inferred : TrackingState_NotTracked );
+      joint.Position.X    = joint.Position.Y = 0;
+      joint.Position.Z    = 2;
+
+      ofPoint point = center + ofPoint( ofRandom( -150, 150 ), ofRandom( -400, 400 ) );
+      body.setJoint( j, joint, point, point * ( 512.f / 1920.f ) );
+    }
+  }
+  frame.buildIndex();
+
+  SkeletonRenderer renderer;
+  double           micros = measure( 10000, [ & ](){ renderer.build( frame ); } );
+
+  ofLogNotice( "SkeletonRenderer" ) << BODY_COUNT << " bodies: " << micros << " us / build, "
+                                    << renderer.getNumLineVertices() << " line and "
+                                    << renderer.getNumTriangleVertices() << " triangle vertices";
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkColorConversion()
+{
+  // a full color frame of smooth gradients with noise, so every clamp and chroma pair is exercised
+  const int width  = 1920;
+  const int height = 1080;
+
+  vector< unsigned char > yuy2( width * height * 2 );
+  for( int y = 0; y < height; ++y )
+  {
+    for( int x = 0; x < width; x += 2 )
+    {
+      unsigned char* p = &yuy2[ ( y * width + x ) * 2 ];
+      p[ 0 ] = ( unsigned char )ofClamp( 255.f * x / width + ofRandom( -8, 8 ), 0, 255 );
+      p[ 1 ] = ( unsigned char )ofClamp( 255.f * y / height + ofRandom( -8, 8 ), 0, 255 );
+      p[ 2 ] = ( unsigned char )ofClamp( p[ 0 ] + ofRandom( -8, 8 ), 0, 255 );
+      p[ 3 ] = ( unsigned char )ofClamp( 255.f - 255.f * x / width + ofRandom( -8, 8 ), 0, 255 );
+    }
+  }
+
+  vector< unsigned char > dst( width * height * 4 );
+
+  const PixelFormat formats[] = { PIXEL_FORMAT_RGBA, PIXEL_FORMAT_BGRA, PIXEL_FORMAT_RGB, PIXEL_FORMAT_GRAY };
+  const char*       names[]   = { "RGBA", "BGRA", "RGB", "GRAY" };
+  for( int k = 0; k < 4; ++k )
+  {
+    double micros = measure( 50, [ & ](){ convertYuy2( yuy2.data(), dst.data(), formats[ k ], width, height ); } );
+
+    // largest difference against the per pixel reference, the simd rows must match it exactly
+    const int channels = getNumChannels( formats[ k ] );
+    int       diff     = 0;
+    for( int i = 0; i < width * height; ++i )
+    {
+      const unsigned char* s = &yuy2[ ( i & ~1 ) * 2 ];
+      const unsigned char* d = &dst[ i * channels ];
+      unsigned char        r, g, b;
+      yuvToRgb( yuy2[ i * 2 ], s[ 1 ], s[ 3 ], r, g, b );
+      if( formats[ k ] == PIXEL_FORMAT_GRAY )
+      {
+        diff = max( diff, abs( d[ 0 ] - yuy2[ i * 2 ] ) );
+        continue;
+      }
+      if( formats[ k ] == PIXEL_FORMAT_BGRA ) std::swap( r, b );
+      diff = max( diff, max( abs( d[ 0 ] - r ), max( abs( d[ 1 ] - g ), abs( d[ 2 ] - b ) ) ) );
+    }
+
+    ofLogNotice( "ColorConversion" ) << "YUY2 to " << names[ k ] << ": " << micros << " us / frame, max difference " << diff;
+  }
+
+  const int scales[] = { 2, 4 };
+  for( int k : scales )
+  {
+    double micros = measure( 50, [ & ](){ convertYuy2( yuy2.data(), dst.data(), PIXEL_FORMAT_RGBA, width, height, k ); } );
+    ofLogNotice( "ColorConversion" ) << "YUY2 to RGBA 1/" << k << ": " << micros << " us / frame";
+  }
+
+  const ScaleFilter filters[]      = { SCALE_FILTER_BOX, SCALE_FILTER_BILINEAR };
+  const char*       filter_names[] = { "box", "bilinear" };
+  for( int f = 0; f < 2; ++f )
+  {
+    ColorResampler resampler;
+    resampler.setup( width, height, ofRectangle( 480, 270, 960, 540 ), 0.75f, filters[ f ] );
+
+    double micros = measure( 50, [ & ](){ resampler.resampleYuy2( yuy2.data(), dst.data(), PIXEL_FORMAT_RGBA ); } );
+    ofLogNotice( "ColorResampler" ) << "YUY2 crop to RGBA " << resampler.getWidth() << "x" << resampler.getHeight()
+                                    << " " << filter_names[ f ] << ": " << micros << " us / frame";
+  }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkStreamRead()
+{
+  // per frame cost of StreamT::readFrame() on a depth sized mock reader
+  const int num_frames = 2000;
+
+  MockReader reader( 512, 424 );
+
+  const char* names[] = { "copy", "zero copy", "zero copy, handle held a frame" };
+  for( int k = 0; k < 3; ++k )
+  {
+    MockStream stream;
+    stream.setup( reader );
+    if( k > 0 ) stream.setZeroCopy( true );
+
+    // the main thread keeps the last handle until the next frame, the pool copies it out then
+    FrameHandle::Ref held;
+    int              readed = 0;
+    double           micros = measure( num_frames, [ & ]()
+    {
+      if( stream.read() ) ++readed;
+      if( k == 2 ) held = stream.getFrameHandle();
+    } );
+
+    ofLogNotice( "StreamT" ) << names[ k ] << ": " << micros << " us / read, " << readed << " of " << num_frames + 1 << " frames read";
+  }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxKinect2.h"
+
+// headless timings of the processing kernels on synthetic frames, see ofApp::setup()
+class ofApp : public ofBaseApp
+{
+public:
+  void setup();
+  void update();
+
+  void benchmarkMarkers();
+  void benchmarkJointFilters();
+  void benchmarkSkeletonRenderer();
+  void benchmarkColorConversion();
+  void benchmarkStreamRead();
+};
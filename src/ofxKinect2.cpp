@@ -9,6 +9,15 @@ namespace ofxKinect2
     if( inited ) return;
     inited = true;
   }
+
+  // frame RelativeTime runs on the performance counter
+  UINT64 getRelativeTime()
+  {
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter( &counter );
+    QueryPerformanceFrequency( &frequency );
+    return ( UINT64 )( counter.QuadPart / frequency.QuadPart * 10000000 + counter.QuadPart % frequency.QuadPart * 10000000 / frequency.QuadPart );
+  }
 }
 
 using namespace ofxKinect2;
@@ -75,6 +84,7 @@ void Device::update()
   {
     s->is_frame_new     = s->kinect2_timestamp != s->opengl_timestamp;
     s->opengl_timestamp = s->kinect2_timestamp;
+    s->notifyEvents();
   }
 }
 
@@ -96,10 +106,139 @@ bool Stream::setup( Device& _device, SensorType _sensor_type )
   frame.data_size      = 0;
   is_frame_new         = false;
   texture_needs_update = false;
+  downscale            = 1;
+  is_zero_copy         = false;
+  frame_arrived        = 0;
+  is_frame_pending     = false;
+
+  return true;
+}
+
+// Stream::setPixelFormat
+//----------------------------------------------------------
+bool Stream::setPixelFormat( PixelFormat _format )
+{
+  if( isOpen() )
+  {
+    ofLogWarning( "ofxKinect2::Stream" ) << "Set the pixel format before open().";
+    return false;
+  }
+  if( !isPixelFormatSupported( _format ) )
+  {
+    ofLogWarning( "ofxKinect2::Stream" ) << "Unsupported pixel format for this stream.";
+    return false;
+  }
+  frame.mode.pixel_format = _format;
+  return true;
+}
+
+// Stream::setDownscale
+//----------------------------------------------------------
+bool Stream::setDownscale( int _factor )
+{
+  if( isOpen() )
+  {
+    ofLogWarning( "ofxKinect2::Stream" ) << "Set the downscale before open().";
+    return false;
+  }
+  downscale = max( _factor, 1 );
+  return true;
+}
+
+// Stream::setZeroCopy
+//----------------------------------------------------------
+bool Stream::setZeroCopy( bool _enabled, int _max_pooled )
+{
+  if( isOpen() )
+  {
+    ofLogWarning( "ofxKinect2::Stream" ) << "Set zero copy before open().";
+    return false;
+  }
+  if( _enabled && !isZeroCopySupported() )
+  {
+    ofLogWarning( "ofxKinect2::Stream" ) << "Zero copy is not supported for this stream.";
+    return false;
+  }
 
+  is_zero_copy = _enabled;
+  if( !is_zero_copy ) frame_pool.reset();
+  else if( !frame_pool ) frame_pool = FramePool::create( _max_pooled );
+  else frame_pool->setMaxPooled( _max_pooled );
   return true;
 }
 
+// Stream::publishFrame
+//----------------------------------------------------------
+void Stream::publishFrame( IUnknown* _p_frame )
+{
+  FrameHandle::Ref handle = frame_pool->wrap( _p_frame, ( const unsigned short* )frame.data, frame.width, frame.height, frame.timestamp );
+  frame.data              = ( void* )handle->getData();
+  std::atomic_store( &frame_handle, handle );
+}
+
+// Stream::readFrameDescription
+//----------------------------------------------------------
+HRESULT Stream::readFrameDescription( IFrameDescription* _p_description )
+{
+  FrameDescription d;
+  HRESULT          hr = _p_description ? S_OK : E_FAIL;
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_Width( &d.width );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_Height( &d.height );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_HorizontalFieldOfView( &d.horizontal_field_of_view );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_VerticalFieldOfView( &d.vertical_field_of_view );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_DiagonalFieldOfView( &d.diagonal_field_of_view );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_BytesPerPixel( &d.bytes_per_pixel );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_description->get_LengthInPixels( &d.length_in_pixels );
+  }
+
+  if( SUCCEEDED( hr ) && ( d.width <= 0 || d.height <= 0 || d.length_in_pixels != ( unsigned int )( d.width * d.height ) ) )
+  {
+    ofLogWarning( "ofxKinect2::Stream" ) << "Invalid frame description.";
+    hr = E_FAIL;
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    description                    = d;
+    frame.width                    = d.width;
+    frame.height                   = d.height;
+    frame.horizontal_field_of_view = d.horizontal_field_of_view;
+    frame.vertical_field_of_view   = d.vertical_field_of_view;
+    frame.diagonal_field_of_view   = d.diagonal_field_of_view;
+    frame.mode.resolution_x        = d.width;
+    frame.mode.resolution_y        = d.height;
+  }
+
+  return hr;
+}
+
 // Stream::open
 //----------------------------------------------------------
 bool Stream::open()
@@ -120,6 +259,8 @@ void Stream::close()
     frame.stride = 0;
     frame.data = nullptr;
     frame.data_size = 0;
+    is_frame_pending = false;
+    std::atomic_store( &frame_handle, FrameHandle::Ref() );
     stopThread();
     unlock();
   }
@@ -152,7 +293,7 @@ bool Stream::readFrame()
 
 // Stream::updateTimestamp
 //----------------------------------------------------------
-void Stream::updateTimestamp( Frame _frame )
+void Stream::updateTimestamp( const Frame& _frame )
 {
   kinect2_timestamp = _frame.timestamp;
 }
@@ -199,104 +340,79 @@ void Stream::draw( float _x, float _y, float _w, float _h )
 
 
 
-// ColorStream::readFrame
+// ColorStream::acquire
 //----------------------------------------------------------
-bool ColorStream::readFrame()
+HRESULT ColorStream::acquire( IColorFrame* _p_frame )
 {
-  bool readed = false;
-  if( !stream.p_color_frame_reader )
-  {
-    ofLogWarning( "ofxKinect2::ColorStream" ) << "Stream is not open.";
-    return readed;
-  }
-  Stream::readFrame();
-
-  IColorFrame* p_frame = nullptr;
-  HRESULT      hr      = stream.p_color_frame_reader->AcquireLatestFrame( &p_frame );
+  ColorImageFormat image_format = ColorImageFormat_None;
+  HRESULT          hr           = _p_frame->get_RawColorImageFormat( &image_format );
 
   if( SUCCEEDED( hr ) )
   {
-    IFrameDescription* p_frame_description = nullptr;
-    ColorImageFormat   image_format        = ColorImageFormat_None;
-
-    hr = p_frame->get_RelativeTime( ( INT64* )&frame.timestamp );
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_FrameDescription( &p_frame_description );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Width( &frame.width );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Height( &frame.height );
-    }
-
-    if( SUCCEEDED( hr ) )
+    // the sensor sends YUY2, which our own kernels convert while writing the back buffer
+    if( image_format == ColorImageFormat_Yuy2 || image_format == ColorImageFormat_Rgba || image_format == ColorImageFormat_Bgra )
     {
-      hr = p_frame_description->get_HorizontalFieldOfView( &frame.horizontal_field_of_view );
+      raw_format = image_format;
+      hr         = _p_frame->AccessRawUnderlyingBuffer( ( UINT* )&frame.data_size, reinterpret_cast< BYTE** >( &frame.data ) );
     }
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_VerticalFieldOfView( &frame.vertical_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_DiagonalFieldOfView( &frame.diagonal_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_RawColorImageFormat( &image_format );
-    }
-
-    if( SUCCEEDED( hr ) )
+    else
     {
       if( buffer == nullptr )
       {
         buffer = new unsigned char[ frame.width * frame.height * 4 ];
       }
-      if( image_format == ColorImageFormat_Rgba )
-      {
-        hr = p_frame->AccessRawUnderlyingBuffer( ( UINT* )&frame.data_size, reinterpret_cast< BYTE** >( &frame.data ) );
-      }
-      else
-      {
-        frame.data      = buffer;
-        frame.data_size = frame.width * frame.height * 4 * sizeof( unsigned char );
-        hr = p_frame->CopyConvertedFrameDataToArray( ( UINT )frame.data_size, reinterpret_cast< BYTE* >( frame.data ), ColorImageFormat_Rgba );
-      }
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      readed = true;
-      setPixels( frame );
+      raw_format      = frame.mode.pixel_format == PIXEL_FORMAT_YUY2 ? ColorImageFormat_Yuy2 : ColorImageFormat_Rgba;
+      frame.data      = buffer;
+      frame.data_size = frame.width * frame.height * ( raw_format == ColorImageFormat_Yuy2 ? 2 : 4 ) * sizeof( unsigned char );
+      hr = _p_frame->CopyConvertedFrameDataToArray( ( UINT )frame.data_size, reinterpret_cast< BYTE* >( frame.data ), raw_format );
     }
-
-    safe_release( p_frame_description );
   }
 
-  safe_release( p_frame );
-
-  return readed;
+  return hr;
 }
 
 // ColorStream::setPixels
 //----------------------------------------------------------
-void ColorStream::setPixels( Frame _frame )
+void ColorStream::setPixels( const Frame& _frame )
 {
   Stream::updateTimestamp( _frame );
 
   const unsigned char * src = ( const unsigned char* )_frame.data;
   if( !src ) return;
 
-  pix.getBackBuffer().setFromPixels( src, _frame.width, _frame.height, OF_IMAGE_COLOR_ALPHA );
+  const PixelFormat format = _frame.mode.pixel_format;
+
+  if( isResampled() && format != PIXEL_FORMAT_YUY2 )
+  {
+    // integer downscale folds into the scale
+    if( !resampler.isSetup( _frame.width, _frame.height ) )
+    {
+      resampler.setup( _frame.width, _frame.height, crop, scale / downscale, scale_filter );
+      pix.allocate( resampler.getWidth(), resampler.getHeight(), getNumChannels( format ) );
+    }
+
+    unsigned char* dst = pix.getBackBuffer().getData();
+    if( raw_format == ColorImageFormat_Yuy2 ) resampler.resampleYuy2( src, dst, format );
+    else                                      resampler.resampleRgba( src, raw_format == ColorImageFormat_Bgra, dst, format );
+    pix.swap();
+    return;
+  }
+
+  unsigned char* dst = pix.getBackBuffer().getData();
+  if( raw_format == ColorImageFormat_Yuy2 )
+  {
+    convertYuy2( src, dst, format, _frame.width, _frame.height, downscale );
+  }
+  else if( format != PIXEL_FORMAT_YUY2 )
+  {
+    convertRgba( src, raw_format == ColorImageFormat_Bgra, dst, format, _frame.width, _frame.height, downscale );
+  }
+
+  if( format == PIXEL_FORMAT_YUY2 )
+  {
+    extractYuy2Luma( src, luma.getBackBuffer().getData(), _frame.width, _frame.height );
+    luma.swap();
+  }
   pix.swap();
 }
 
@@ -304,86 +420,130 @@ void ColorStream::setPixels( Frame _frame )
 //----------------------------------------------------------
 void ColorStream::update()
 {
-  if( !tex.isAllocated() )
-  {
-    tex.allocate( getWidth(), getHeight(), GL_RGB );
-  }
+  const PixelFormat format = frame.mode.pixel_format;
 
   if( lock() )
   {
-    tex.loadData( pix.getFrontBuffer() );
+    // the resampled size is known with the first frame, follow the view
+    const ofPixels& view = format == PIXEL_FORMAT_YUY2 ? luma.getFrontBuffer() : pix.getFrontBuffer();
+    if( view.isAllocated() )
+    {
+      if( !tex.isAllocated() || tex.getWidth() != view.getWidth() || tex.getHeight() != view.getHeight() )
+      {
+        int channels = view.getNumChannels();
+        tex.allocate( view.getWidth(), view.getHeight(), channels == 4 ? GL_RGBA : ( channels == 3 ? GL_RGB : GL_LUMINANCE ) );
+      }
+
+      if( format == PIXEL_FORMAT_BGRA ) tex.loadData( view.getData(), view.getWidth(), view.getHeight(), GL_BGRA );
+      else                              tex.loadData( view );
+    }
     Stream::update();
     unlock();
   }
 }
 
-// ColorStream::open
+// ColorStream::setCrop
 //----------------------------------------------------------
-bool ColorStream::open()
+bool ColorStream::setCrop( const ofRectangle& _rect )
 {
-  if( !device->isOpen() )
+  if( isOpen() )
   {
-    ofLogWarning( "ofxKinect2::ColorStream" ) << "No ready Kinect2 found.";
+    ofLogWarning( "ofxKinect2::ColorStream" ) << "Set the crop before open().";
     return false;
   }
+  crop = _rect;
+  return true;
+}
 
-  IColorFrameSource* p_source = nullptr;
-  HRESULT            hr       = device->get().kinect2->get_ColorFrameSource( &p_source );
-
-  if( SUCCEEDED( hr ) )
-  {
-    hr = p_source->OpenReader( &stream.p_color_frame_reader );
-  }
-
-  IFrameDescription* p_frame_description = nullptr;
-  p_source->get_FrameDescription( &p_frame_description );
-  
-  if( SUCCEEDED( hr ) )
+// ColorStream::setScale
+//----------------------------------------------------------
+bool ColorStream::setScale( float _scale, ScaleFilter _filter )
+{
+  if( isOpen() )
   {
-    int res_x               = 0;
-    int res_y               = 0;
-    hr                      = p_frame_description->get_Width( &res_x );
-    hr                      = p_frame_description->get_Width( &res_y );
-    frame.mode.resolution_x = res_x;
-    frame.mode.resolution_y = res_y;
-    frame.width             = res_x;
-    frame.height            = res_y;
-
-    pix.allocate( res_x, res_y, 4 );
+    ofLogWarning( "ofxKinect2::ColorStream" ) << "Set the scale before open().";
+    return false;
   }
-  safe_release( p_frame_description );
-  safe_release( p_source );
-
-  if( FAILED( hr ) )
+  if( _scale <= 0 || _scale > 1 )
   {
-    ofLogWarning( "ofxKinect2::ColorStream" ) << "Can't open stream.";
+    ofLogWarning( "ofxKinect2::ColorStream" ) << "Scale must be in ( 0, 1 ].";
     return false;
   }
+  scale        = _scale;
+  scale_filter = _filter;
+  return true;
+}
 
-  return Stream::open();
+// ColorStream::isPixelFormatSupported
+//----------------------------------------------------------
+bool ColorStream::isPixelFormatSupported( PixelFormat _format ) const
+{
+  return _format == PIXEL_FORMAT_RGBA || _format == PIXEL_FORMAT_BGRA || _format == PIXEL_FORMAT_RGB ||
+         _format == PIXEL_FORMAT_GRAY || _format == PIXEL_FORMAT_YUY2;
 }
 
-// ColorStream::close
+// ColorStream::openSource
 //----------------------------------------------------------
-void ColorStream::close()
+HRESULT ColorStream::openSource( IColorFrameSource* _p_source )
 {
-  Stream::close();
-  safe_release( stream.p_color_frame_reader );
+  const int res_x = description.width;
+  const int res_y = description.height;
+
+  if( frame.mode.pixel_format == PIXEL_FORMAT_YUY2 )
+  {
+    downscale = 1;
+    luma.allocate( res_x, res_y, 1 );
+  }
+
+  // resampled buffers are allocated with the first frame
+  if( !isResampled() || frame.mode.pixel_format == PIXEL_FORMAT_YUY2 )
+  {
+    pix.allocate( res_x / downscale, res_y / downscale, getNumChannels( frame.mode.pixel_format ) );
+  }
+
+  return S_OK;
 }
 
 // ColorStream::getColorAt
 //----------------------------------------------------------
 ofColor ColorStream::getColorAt( int _x, int _y )
 {
-  if( !pix.getFrontBuffer().isAllocated() || _x < 0 || _y < 0 || _x >= pix.getFrontBuffer().getWidth() || _y >= pix.getFrontBuffer().getHeight() )
+  const ofPixels& p = pix.getFrontBuffer();
+
+  // color space coordinates, the pixels may be cropped and scaled
+  if( isResampled() && frame.mode.pixel_format != PIXEL_FORMAT_YUY2 )
+  {
+    const ofRectangle& c = resampler.getCrop();
+    _x                   = ( int )floor( ( _x - c.x ) * p.getWidth() / c.width );
+    _y                   = ( int )floor( ( _y - c.y ) * p.getHeight() / c.height );
+  }
+  else
+  {
+    _x /= downscale;
+    _y /= downscale;
+  }
+  if( !p.isAllocated() || _x < 0 || _y < 0 || _x >= p.getWidth() || _y >= p.getHeight() )
   {
     return ofColor( 0, 0, 0, 0 );
   }
 
-  int     index = ( _x + _y * pix.getFrontBuffer().getWidth() ) * 4;
-  ofColor color = ofColor( pix.getFrontBuffer()[ index ], pix.getFrontBuffer()[ index + 1 ], pix.getFrontBuffer()[ index + 2 ], pix.getFrontBuffer()[ index + 3 ] );
+  const unsigned char* src = p.getData() + ( _x + _y * p.getWidth() ) * p.getNumChannels();
+  switch( frame.mode.pixel_format )
+  {
+  case PIXEL_FORMAT_YUY2:
+    {
+      // the pair shares u and v
+      const unsigned char* pair = p.getData() + ( ( _x & ~1 ) + _y * p.getWidth() ) * 2;
+      ofColor              color;
+      yuvToRgb( pair[ ( _x & 1 ) * 2 ], pair[ 1 ], pair[ 3 ], color.r, color.g, color.b );
+      return color;
+    }
 
-  return color;
+  case PIXEL_FORMAT_BGRA: return ofColor( src[ 2 ], src[ 1 ], src[ 0 ], src[ 3 ] );
+  case PIXEL_FORMAT_RGB:  return ofColor( src[ 0 ], src[ 1 ], src[ 2 ] );
+  case PIXEL_FORMAT_GRAY: return ofColor( src[ 0 ] );
+  default:                return ofColor( src[ 0 ], src[ 1 ], src[ 2 ], src[ 3 ] );
+  }
 }
 
 // ColorStream::getColorAt
@@ -393,17 +553,11 @@ ofColor ColorStream::getColorAt( ofVec2f _color_point )
   return getColorAt( _color_point.x, _color_point.y );
 }
 
+// ColorStream::getFloatColorAt
+//----------------------------------------------------------
 ofFloatColor ColorStream::getFloatColorAt( int _x, int _y )
 {
-  if( !pix.getFrontBuffer().isAllocated() || _x < 0 || _y < 0 || _x >= pix.getFrontBuffer().getWidth() || _y >= pix.getFrontBuffer().getHeight() )
-  {
-    return ofFloatColor( 0, 0, 0, 0 );
-  }
-
-  int          index = ( _x + _y * pix.getFrontBuffer().getWidth() ) * 4;
-  ofFloatColor color = ofColor( pix.getFrontBuffer()[ index ] / 255.f, pix.getFrontBuffer()[ index + 1 ] / 255.f, pix.getFrontBuffer()[ index + 2 ] / 255.f, pix.getFrontBuffer()[ index + 3 ] / 255.f );
-
-  return color;
+  return ofFloatColor( getColorAt( _x, _y ) );
 }
 
 // ColorStream::getFloatColorAt
@@ -453,122 +607,209 @@ float ColorStream::getGamma()
 
 
 
-// DepthStream
+// DepthStream::setPixels
 //----------------------------------------------------------
-bool DepthStream::readFrame()
+void DepthStream::setPixels( const Frame& _frame )
 {
-  bool readed = false;
-  if( !stream.p_depth_frame_reader )
-  {
-    ofLogWarning( "ofxKinect2::DepthStream" ) << "Stream is not open.";
-    return readed;
-  }
-  Stream::readFrame();
+  Stream::updateTimestamp( _frame );
+  
+  const unsigned short *pixels = ( const unsigned short*)_frame.data;
+  if( !pixels ) return;
 
-  IDepthFrame* p_frame = nullptr;
-  HRESULT      hr      = stream.p_depth_frame_reader->AcquireLatestFrame( &p_frame );
+  int w = _frame.width;
+  int h = _frame.height;
 
-  if( SUCCEEDED( hr ) )
+  switch( _frame.mode.pixel_format )
   {
-    IFrameDescription* p_frame_description = nullptr;
-
-    hr = p_frame->get_RelativeTime( ( INT64* )&frame.timestamp );
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_FrameDescription( &p_frame_description );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Width( &frame.width );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Height( &frame.height );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_HorizontalFieldOfView( &frame.horizontal_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_VerticalFieldOfView( &frame.vertical_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_DiagonalFieldOfView( &frame.diagonal_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_DepthMinReliableDistance( ( USHORT* )&near_value );
-    }
+  case PIXEL_FORMAT_FLOAT:
+    float_pix.allocate( w / downscale, h / downscale, 1 );
+    convertShortToFloat( pixels, float_pix.getBackBuffer().getData(), w, h, downscale, false, 0.001f );
+    break;
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_DepthMaxReliableDistance( ( USHORT* )&far_value );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_DepthMinReliableDistance( ( USHORT* )&near_value );
-    }
+  case PIXEL_FORMAT_GRAY:
+    char_pix.allocate( w / downscale, h / downscale, 1 );
+    convertShortToByte( pixels, char_pix.getBackBuffer().getData(), w, h, downscale, false, is_invert ? far_value : near_value, is_invert ? near_value : far_value );
+    break;
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->AccessUnderlyingBuffer( ( UINT* )&frame.data_size, reinterpret_cast< UINT16** >( &frame.data ) );
-    }
+  default:
+    break;
+  }
 
-    if( SUCCEEDED( hr ) )
-    {
-      readed = true;
-      setPixels( frame );
-    }
+  // raw millimeters with GRAY16, next to the other formats only for the pyramid level 0 and retained consumers
+  const bool is_raw = !isPixelsFromHandle() &&
+                      ( _frame.mode.pixel_format == PIXEL_FORMAT_GRAY16 || num_raw_users > 0 || pyramid.getBackBuffer().getNumLevels() );
+  if( is_raw )
+  {
+    pix.allocate( w / downscale, h / downscale, 1 );
+    convertShort( pixels, pix.getBackBuffer().getData(), w, h, downscale, false );
+  }
 
-    safe_release( p_frame_description );
+  if( pyramid.getBackBuffer().getNumLevels() )
+  {
+    pyramid.getBackBuffer().build( pixels, w, h );
   }
 
-  safe_release( p_frame );
+  if( is_touch_enabled )
+  {
+    touch_detector.update( pixels, w, h, _frame.timestamp );
+  }
 
-  return readed;
+  if( is_raw ) pix.swap();
+  float_pix.swap();
+  char_pix.swap();
+  pyramid.swap();
 }
 
-// DepthStream::setPixels
+// DepthStream::notifyEvents
 //----------------------------------------------------------
-void DepthStream::setPixels( Frame _frame )
+void DepthStream::notifyEvents()
 {
-  Stream::updateTimestamp( _frame );
-  
-  const unsigned short *pixels = ( const unsigned short*)_frame.data;
-  if( !pixels ) return;
-
-  int w = _frame.width;
-  int h = _frame.height;
-  
-  pix.allocate( w, h, 1 );
-  pix.getBackBuffer().setFromPixels( pixels, w, h, OF_IMAGE_GRAYSCALE );
-  pix.swap();
+  const UINT64             now = getRelativeTime();
+  TouchDetector::EventType type;
+  Touch                    touch;
+  while( touch_detector.popEvent( type, touch, now ) )
+  {
+    ofNotifyEvent( type == TouchDetector::EVENT_DOWN ? touch_down : ( type == TouchDetector::EVENT_MOVED ? touch_moved : touch_up ), touch, this );
+  }
 }
 
-// DepthStream::update
+// DepthStream::learnTouchSurface
+//----------------------------------------------------------
+void DepthStream::learnTouchSurface( int _num_frames )
+{
+  if( lock() )
+  {
+    touch_detector.learnSurface( _num_frames );
+    unlock();
+  }
+}
+
+// DepthStream::setTouchHeightBand
+//----------------------------------------------------------
+void DepthStream::setTouchHeightBand( unsigned short _min_height, unsigned short _max_height )
+{
+  if( lock() )
+  {
+    touch_detector.setHeightBand( _min_height, _max_height );
+    unlock();
+  }
+}
+
+// DepthStream::setTouchAreaRange
+//----------------------------------------------------------
+void DepthStream::setTouchAreaRange( int _min_area, int _max_area )
+{
+  if( lock() )
+  {
+    touch_detector.setAreaRange( _min_area, _max_area );
+    unlock();
+  }
+}
+
+// DepthStream::setTouchMaxDistance
+//----------------------------------------------------------
+void DepthStream::setTouchMaxDistance( float _max_distance )
+{
+  if( lock() )
+  {
+    touch_detector.setMaxDistance( _max_distance );
+    unlock();
+  }
+}
+
+// DepthStream::getTouches
+//----------------------------------------------------------
+void DepthStream::getTouches( vector< Touch >& _touches )
+{
+  if( lock() )
+  {
+    _touches = touch_detector.getTouches();
+    unlock();
+  }
+}
+
+// DepthStream::getTouchMask
+//----------------------------------------------------------
+void DepthStream::getTouchMask( vector< unsigned char >& _mask )
+{
+  if( lock() )
+  {
+    _mask = touch_detector.getMask();
+    unlock();
+  }
+}
+
+// DepthStream::getTouchSurface
+//----------------------------------------------------------
+void DepthStream::getTouchSurface( vector< unsigned short >& _surface )
+{
+  if( lock() )
+  {
+    _surface = touch_detector.getSurface();
+    unlock();
+  }
+}
+
+// DepthStream::isPixelFormatSupported
+//----------------------------------------------------------
+bool DepthStream::isPixelFormatSupported( PixelFormat _format ) const
+{
+  return _format == PIXEL_FORMAT_GRAY16 || _format == PIXEL_FORMAT_FLOAT || _format == PIXEL_FORMAT_GRAY;
+}
+
+// DepthStream::setPyramid
+//----------------------------------------------------------
+void DepthStream::setPyramid( int _num_levels, DepthPyramidMode _mode )
+{
+  if( lock() )
+  {
+    pyramid.getFrontBuffer().setup( _num_levels - 1, _mode );
+    pyramid.getBackBuffer().setup( _num_levels - 1, _mode );
+    unlock();
+  }
+}
+
+// DepthStream::getPyramidLevel
+//----------------------------------------------------------
+const ofShortPixels& DepthStream::getPyramidLevel( int _level ) const
+{
+  if( _level <= 0 || _level >= getNumPyramidLevels() ) return getPixels();
+  return pyramid.getFrontBuffer().getLevel( _level - 1 );
+}
+
+// DepthStream::update
 //----------------------------------------------------------
 void DepthStream::update()
 {
+  const PixelFormat format = frame.mode.pixel_format;
+  const int         w      = getWidth() / downscale;
+  const int         h      = getHeight() / downscale;
+
   if( !tex.isAllocated() )
   {
-    tex.allocate( getWidth(), getHeight(), GL_RGBA, true, GL_LUMINANCE, GL_UNSIGNED_SHORT );
+    if( format == PIXEL_FORMAT_GRAY )       tex.allocate( w, h, GL_LUMINANCE );
+    else if( format == PIXEL_FORMAT_FLOAT ) tex.allocate( w, h, GL_LUMINANCE32F_ARB );
+    else                                    tex.allocate( w, h, GL_RGBA, true, GL_LUMINANCE, GL_UNSIGNED_SHORT );
   }
 
   if( lock() )
   {
-    ofShortPixels _pix;
-    depthRemapToRange( pix.getFrontBuffer(), _pix, near_value, far_value, is_invert );
-    tex.loadData( _pix );
+    if( format == PIXEL_FORMAT_GRAY )
+    {
+      tex.loadData( char_pix.getFrontBuffer() );
+    }
+    else if( format == PIXEL_FORMAT_FLOAT )
+    {
+      tex.loadData( float_pix.getFrontBuffer() );
+    }
+    else
+    {
+      ofShortPixels    _pix;
+      FrameHandle::Ref handle = getFrameHandle();
+      if( isPixelsFromHandle() && handle ) depthRemapToRange( handle->getData(), handle->getWidth(), handle->getHeight(), _pix, near_value, far_value, is_invert );
+      else                                 depthRemapToRange( pix.getFrontBuffer(), _pix, near_value, far_value, is_invert );
+      tex.loadData( _pix );
+    }
     Stream::update();
 
     unlock();
@@ -597,12 +838,31 @@ const ofShortPixels& DepthStream::getPixels( int _near, int _far, bool _invert )
 //----------------------------------------------------------
 unsigned short DepthStream::getDepthAt( int _x, int _y )
 {
+  // depth space coordinates, the pixels may be downscaled
+  _x /= downscale;
+  _y /= downscale;
+
+  if( isPixelsFromHandle() )
+  {
+    FrameHandle::Ref handle = getFrameHandle();
+    if( !handle ) return 0;
+
+    handle->lock();
+    unsigned short depth = handle->getData()[ _y * handle->getWidth() + _x ];
+    handle->unlock();
+    return depth;
+  }
+
   int index = ( _y * pix.getFrontBuffer().getWidth() ) + _x;
 
   if( pix.getFrontBuffer().isAllocated() )
   {
     return pix.getFrontBuffer()[ index];
   }
+  else if( float_pix.getFrontBuffer().isAllocated() )
+  {
+    return ( unsigned short )( float_pix.getFrontBuffer()[ index ] * 1000 + 0.5f );
+  }
   else
   {
     ofLogNotice( "ofKinect2::DepthStream" ) << "Cannot get depth.";
@@ -617,44 +877,18 @@ unsigned short DepthStream::getDepthAt( ofVec2f _depth_point )
   return getDepthAt( _depth_point.x, _depth_point.y );
 }
 
-// DepthStream::open
+// DepthStream::openSource
 //----------------------------------------------------------
-bool DepthStream::open()
+HRESULT DepthStream::openSource( IDepthFrameSource* _p_source )
 {
-  if( !device->isOpen() )
-  {
-    ofLogWarning( "ofxKinect2::DepthStream" ) << "No ready Kinect2 found.";
-    return false;
-  }
-
-  is_invert  = true;
-  near_value = 0;
-  far_value  = 10000;
-
-  IDepthFrameSource* p_source = nullptr;
-  HRESULT            hr       = device->get().kinect2->get_DepthFrameSource( &p_source );
+  HRESULT hr = _p_source->get_DepthMinReliableDistance( &min_reliable_distance );
 
   if( SUCCEEDED( hr ) )
   {
-    hr = p_source->OpenReader( &stream.p_depth_frame_reader );
-  }
-
-  safe_release( p_source );
-  if( FAILED( hr ) )
-  {
-    ofLogWarning( "ofxKinect2::DepthStream" ) << "Can't open stream.";
-    return false;
+    hr = _p_source->get_DepthMaxReliableDistance( &max_reliable_distance );
   }
 
-  return Stream::open();
-}
-
-// DepthStream::close
-//----------------------------------------------------------
-void DepthStream::close()
-{
-  Stream::close();
-  safe_release( stream.p_depth_frame_reader );
+  return hr;
 }
 
 
@@ -662,290 +896,187 @@ void DepthStream::close()
 
 
 
-// IrStream::readFrame
+// IrStream::processRaw
 //----------------------------------------------------------
-bool IrStream::readFrame()
+void IrStream::processRaw( const unsigned short* _pixels, int _width, int _height, UINT64 _timestamp )
 {
-  bool readed = false;
-  if( !stream.p_infrared_frame_reader )
+  if( !is_markers_enabled ) return;
+
+  // the mapper has no table until the sensor runs, retry until it has one
+  if( p_mapper && !marker_detector.hasCameraTable() )
   {
-    ofLogWarning( "ofxKinect2::IrStream" ) << "Stream is not open.";
-    return readed;
+    vector< ofVec2f > table;
+    if( p_mapper->queryDepthFrameToCameraSpaceTable( table ) ) marker_detector.setCameraTable( table );
   }
-  Stream::readFrame();
 
-  IInfraredFrame* p_frame = nullptr;
-  HRESULT         hr      = stream.p_infrared_frame_reader->AcquireLatestFrame( &p_frame );
-
-  if( SUCCEEDED( hr ) )
+  // snapshot of the depth under a short lock, the detection runs without holding it
+  const unsigned short* depth  = nullptr;
+  const size_t          length = ( size_t )( _width * _height );
+  if( p_depth )
   {
-    IFrameDescription* p_frame_description = nullptr;
-
-    hr = p_frame->get_RelativeTime( ( INT64* )&frame.timestamp );
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_FrameDescription( &p_frame_description );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Width( &frame.width );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Height( &frame.height );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_HorizontalFieldOfView( &frame.horizontal_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_VerticalFieldOfView( &frame.vertical_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_DiagonalFieldOfView( &frame.diagonal_field_of_view );
-    }
-
-    if( SUCCEEDED( hr ) )
+    FrameHandle::Ref handle = p_depth->getFrameHandle();
+    if( handle && handle->getWidth() == _width && handle->getHeight() == _height )
     {
-      hr = p_frame->AccessUnderlyingBuffer( ( UINT* )&frame.data_size, reinterpret_cast< UINT16** >( &frame.data ) );
+      handle->lock();
+      depth_snapshot.assign( handle->getData(), handle->getData() + length );
+      handle->unlock();
+      depth = depth_snapshot.data();
     }
-
-    if( SUCCEEDED( hr ) )
+    else if( p_depth->lock() )
     {
-      readed = true;
-      setPixels( frame );
+      // needs the full resolution GRAY16 output
+      const ofShortPixels& pixels = p_depth->getPixels();
+      if( pixels.getWidth() == _width && pixels.getHeight() == _height )
+      {
+        depth_snapshot.assign( pixels.getData(), pixels.getData() + length );
+        depth = depth_snapshot.data();
+      }
+      p_depth->unlock();
     }
-
-    safe_release( p_frame_description );
   }
 
-  safe_release( p_frame );
-
-  return readed;
+  // markers without depth rather than none when the depth is not available
+  marker_detector.update( _pixels, _width, _height, depth, _timestamp );
 }
 
-// IrStream::setPixels
+// IrStream::setDepth
 //----------------------------------------------------------
-void IrStream::setPixels( Frame _frame )
+void IrStream::setDepth( DepthStream& _depth, Mapper* _mapper )
 {
-  Stream::updateTimestamp( _frame );
-
-  const unsigned short *pixels = ( const unsigned short* )_frame.data;
-  if( !pixels ) return;
-
-  int w = _frame.width;
-  int h = _frame.height;
-  
-  pix.allocate( w, h, 1 );
-  pix.getBackBuffer().setFromPixels( pixels, w, h, OF_IMAGE_GRAYSCALE );
-  pix.swap();
+  if( lock() )
+  {
+    if( p_depth != &_depth )
+    {
+      if( p_depth ) p_depth->releaseRawPixels();
+      _depth.retainRawPixels();
+    }
+    p_depth  = &_depth;
+    p_mapper = _mapper;
+    marker_detector.setCameraTable( vector< ofVec2f >() );
+    unlock();
+  }
 }
 
-// IrStream::update
+// IrStream::setMarkerThreshold
 //----------------------------------------------------------
-void IrStream::update()
+void IrStream::setMarkerThreshold( unsigned short _threshold )
 {
-  if( !tex.isAllocated() )
-  {
-    tex.allocate( getWidth(), getHeight(), GL_LUMINANCE );
-  }
-
   if( lock() )
   {
-    tex.loadData( pix.getFrontBuffer() );
-    Stream::update();
+    marker_detector.setThreshold( _threshold );
     unlock();
   }
 }
 
-// IrStream::open
+// IrStream::setMarkerAreaRange
 //----------------------------------------------------------
-bool IrStream::open()
+void IrStream::setMarkerAreaRange( int _min_area, int _max_area )
 {
-  if( !device->isOpen() )
-  {
-    ofLogWarning( "ofxKinect2::IrStream" ) << "No ready Kinect2 found.";
-    return false;
-  }
-
-  IInfraredFrameSource* p_source = nullptr;
-  HRESULT               hr       = device->get().kinect2->get_InfraredFrameSource( &p_source );
-
-  if( SUCCEEDED( hr ) )
+  if( lock() )
   {
-    hr = p_source->OpenReader( &stream.p_infrared_frame_reader );
+    marker_detector.setAreaRange( _min_area, _max_area );
+    unlock();
   }
+}
 
-  safe_release( p_source );
-  if( FAILED( hr ) )
+// IrStream::setMarkerDepthRadius
+//----------------------------------------------------------
+void IrStream::setMarkerDepthRadius( int _radius )
+{
+  if( lock() )
   {
-    ofLogWarning( "ofxKinect2::IrStream" ) << "Can't open stream.";
-    return false;
+    marker_detector.setDepthRadius( _radius );
+    unlock();
   }
-
-  return Stream::open();
 }
 
-// IrStream::close
+// IrStream::getMarkers
 //----------------------------------------------------------
-void IrStream::close()
+void IrStream::getMarkers( vector< Marker >& _markers )
 {
-  Stream::close();
-  safe_release( stream.p_infrared_frame_reader );
+  if( lock() )
+  {
+    _markers = marker_detector.getMarkers();
+    unlock();
+  }
 }
 
-
-
-
-
-
-
-// BodyIndexStream::readFrame
+// IrStream::getMarkerMask
 //----------------------------------------------------------
-bool BodyIndexStream::readFrame()
+void IrStream::getMarkerMask( vector< unsigned char >& _mask )
 {
-  bool readed = false;
-  if( !stream.p_body_index_frame_reader )
+  if( lock() )
   {
-    ofLogWarning( "ofxKinect2::BodyIndexStream" ) << "Stream is not open.";
-    return readed;
+    _mask = marker_detector.getMask();
+    unlock();
   }
-  Stream::readFrame();
+}
 
-  IBodyIndexFrame* p_frame = nullptr;
-  HRESULT          hr      = stream.p_body_index_frame_reader->AcquireLatestFrame( &p_frame );
 
-  if( SUCCEEDED( hr ) )
-  {
-    IFrameDescription* p_frame_description = nullptr;
 
-    hr = p_frame->get_RelativeTime( ( INT64* )&frame.timestamp );
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame->get_FrameDescription( &p_frame_description );
-    }
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Width( &frame.width );
-    }
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_Height( &frame.height );
-    }
+// BodyIndexStream::setPixels
+//----------------------------------------------------------
+void BodyIndexStream::setPixels( const Frame& _frame )
+{
+  Stream::updateTimestamp( _frame );
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_HorizontalFieldOfView( &frame.horizontal_field_of_view );
-    }
+  const int            w        = _frame.width;
+  const int            h        = _frame.height;
+  const int            ow       = w / downscale;
+  const int            oh       = h / downscale;
+  const int            channels = getNumChannels( _frame.mode.pixel_format );
+  const unsigned char* index    = ( const unsigned char* )_frame.data;
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_VerticalFieldOfView( &frame.vertical_field_of_view );
-    }
+  pix.allocate( ow, oh, channels );
+  unsigned char* pixels = pix.getBackBuffer().getData();
 
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_DiagonalFieldOfView( &frame.diagonal_field_of_view );
-    }
+  if( _frame.mode.pixel_format == PIXEL_FORMAT_GRAY )
+  {
+    convertByte( index, pixels, w, h, downscale );
+    pix.swap();
+    return;
+  }
 
-    unsigned int bpp = 0;
-    if( SUCCEEDED( hr ) )
-    {
-      hr = p_frame_description->get_BytesPerPixel( &bpp );
-    }
+  if( is_index_pixels )
+  {
+    index_pix.allocate( w, h, 1 );
+    memcpy( index_pix.getBackBuffer().getData(), index, w * h );
+    index_pix.swap();
+  }
 
-    if( SUCCEEDED( hr ) )
+  for( int y = 0; y < oh; ++y )
+  {
+    const unsigned char* src = index + y * downscale * w;
+    for( int x = 0; x < ow; ++x, pixels += channels )
     {
-      hr = p_frame->AccessUnderlyingBuffer( ( UINT* )&frame.data_size, reinterpret_cast< BYTE** >( &frame.data ) );
-    }
+      unsigned char p = src[ x * downscale ];
 
-    if( SUCCEEDED( hr ) )
-    {
-      readed = true;
-      setPixels( frame );
+      if( p < BODY_COUNT )
+      {
+        const ofColor& color = colors[ p ];
+        pixels[ 0 ]          = color.r;
+        pixels[ 1 ]          = color.g;
+        pixels[ 2 ]          = color.b;
+        if( channels == 4 ) pixels[ 3 ] = 255;
+      }
+      else
+      {
+        memset( pixels, 0, channels );
+      }
     }
-    safe_release( p_frame_description );
   }
 
-  safe_release( p_frame );
-
-  return readed;
+  pix.swap();
 }
 
-// BodyIndexStream::setPixels
+// BodyIndexStream::isPixelFormatSupported
 //----------------------------------------------------------
-void BodyIndexStream::setPixels( Frame _frame )
+bool BodyIndexStream::isPixelFormatSupported( PixelFormat _format ) const
 {
-  Stream::updateTimestamp( _frame );
-
-  int            w      = _frame.width;
-  int            h      = _frame.height;
-  unsigned char* pixels = new unsigned char[ w * h * 4 ];
-
-  //for( int i  = 0; i < w * h; ++i )
-  //{
-  //  int           index = i * 4;
-  //  unsigned char p     = ( ( unsigned char* )_frame.data )[ i ];
-  //  ofColor       color = colors[ p ];
-  //  
-  //  if( p != 255 )
-  //  {
-  //    pixels[ index + 0 ] = color.r;
-  //    pixels[ index + 1 ] = color.g;
-  //    pixels[ index + 2 ] = color.b;
-  //    pixels[ index + 3 ] = 255;
-  //  }
-  //  else
-  //  {
-  //    pixels[ index + 0 ] = 0;
-  //    pixels[ index + 1 ] = 0;
-  //    pixels[ index + 2 ] = 0;
-  //    pixels[ index + 3 ] = 0;
-  //  }
-  //}
-
-  ofPixels indexPix;
-  indexPix.setFromPixels( ( unsigned char* )_frame.data, w, h, OF_IMAGE_GRAYSCALE );
-
-  int i = 0;
-  for( auto& p : indexPix )
-  {
-    int     index = i * 4;
-    ofColor color = colors[ p ];
-
-    if( p != 255 )
-    {
-      pixels[ index + 0 ] = color.r;
-      pixels[ index + 1 ] = color.g;
-      pixels[ index + 2 ] = color.b;
-      pixels[ index + 3 ] = 255;
-    }
-    else
-    {
-      pixels[ index + 0 ] = 0;
-      pixels[ index + 1 ] = 0;
-      pixels[ index + 2 ] = 0;
-      pixels[ index + 3 ] = 0;
-    }
-    ++i;
-  }
-  
-  pix.allocate( w, h, 4 );
-  pix.getBackBuffer().setFromPixels( pixels, w, h, OF_IMAGE_COLOR_ALPHA );
-  pix.swap();
-
-  delete[] pixels;
+  return _format == PIXEL_FORMAT_RGBA || _format == PIXEL_FORMAT_RGB || _format == PIXEL_FORMAT_GRAY;
 }
 
 // BodyIndexStream::update
@@ -954,7 +1085,8 @@ void BodyIndexStream::update()
 {
   if( !tex.isAllocated() )
   {
-    tex.allocate( getWidth(), getHeight(), GL_RGB );
+    PixelFormat format = frame.mode.pixel_format;
+    tex.allocate( getWidth() / downscale, getHeight() / downscale, format == PIXEL_FORMAT_RGBA ? GL_RGBA : ( format == PIXEL_FORMAT_RGB ? GL_RGB : GL_LUMINANCE ) );
   }
 
   if( lock() )
@@ -965,112 +1097,32 @@ void BodyIndexStream::update()
   }
 }
 
-// BodyIndexStream::open
+
+
+
+
+
+// Body::update
 //----------------------------------------------------------
-bool BodyIndexStream::open()
+void Body::update( IBody* _body )
 {
-  if( !device->isOpen() )
-  {
-    ofLogWarning( "ofxKinect2::BodyIndexStream" ) << "No ready Kinect2 found.";
-    return false;
-  }
+  HRESULT hr = _body->get_HandLeftState( &left_hand_state );
+  hr         = _body->get_HandRightState( &right_hand_state );
 
-  IBodyIndexFrameSource* p_source = nullptr;
-  HRESULT                hr       = device->get().kinect2->get_BodyIndexFrameSource( &p_source );
+  _body->get_LeanTrackingState( &lean_state );
+  _body->get_Lean( &lean );
+
+  hr = _body->GetJoints( JointType_Count, joints );
 
   if( SUCCEEDED( hr ) )
   {
-    hr = p_source->OpenReader( &stream.p_body_index_frame_reader );
+    is_update_scale = false;
   }
-
-  safe_release( p_source );
-  if( FAILED( hr ) )
-  {
-    ofLogWarning( "ofxKinect2::BodyIndexStream" ) << "Can't open stream.";
-    return false;
-  }
-
-  return Stream::open();
-}
-
-// BodyIndexStream::close
-//----------------------------------------------------------
-void BodyIndexStream::close()
-{
-  Stream::close();
-  safe_release( stream.p_infrared_frame_reader );
-}
-
-
-
-
-
-
-// Body::update
-//----------------------------------------------------------
-void Body::update( IBody* _body )
-{
-  joints.resize( JointType_Count );
-  joint_points.resize( JointType_Count );
-
-  HRESULT hr = _body->get_HandLeftState( &left_hand_state );
-  hr         = _body->get_HandRightState( &right_hand_state );
-
-  _body->get_LeanTrackingState( &lean_state );
-
-  PointF pnt;
-  _body->get_Lean( &pnt );
-  
-  CameraSpacePoint cpnt;
-  cpnt.X = pnt.X;
-  cpnt.Y = pnt.Y;
-  cpnt.Z = 0;
-  body_lean = bodyPointToScreen( cpnt );
-
-  hr = _body->GetJoints( JointType_Count, &joints.front() );
-
-  if( SUCCEEDED( hr ) )
-  {
-    is_update_scale = false;
-  }
-}
-
-// Body::jointToScreen
-//----------------------------------------------------------
-ofPoint Body::jointToScreen( const JointType _jointType )
-{
-  CameraSpacePoint bodyPoint = joints[ _jointType ].Position;
-  return bodyPointToScreen( bodyPoint );
-}
-
-// Body::bodyPointToScreen
-//----------------------------------------------------------
-ofPoint Body::bodyPointToScreen( const CameraSpacePoint& _bodyPoint )
-{
-  // Calculate the body's position on the screen
-  ColorSpacePoint    colorPoint = { 0 };
-  ICoordinateMapper* mapper     = nullptr;
-  HRESULT            hr         = device->get().kinect2->get_CoordinateMapper( &mapper );
-  if( SUCCEEDED( hr ) )
-  {
-    mapper->MapCameraPointToColorSpace( _bodyPoint, &colorPoint );
-  }
-  else
-  {
-    ofLogError( "ofxKinect2::Body" ) << "can't get Coordinate Mapper.";
-    return ofPoint( 0, 0 );
-  }
-
-  // TODO: width/ height
-  float screenPointX = static_cast< float >( colorPoint.X );
-  float screenPointY = static_cast< float >( colorPoint.Y );
-
-  return ofPoint( screenPointX, screenPointY );
-}
+}
 
 // Body::drawBody
 //----------------------------------------------------------
-void Body::drawBody()
+void Body::drawBody() const
 {
   if( !is_tracked ) return;
 
@@ -1123,7 +1175,7 @@ void Body::drawBody()
 
 // Body::drawBone
 //----------------------------------------------------------
-void Body::drawBone( JointType _joint0, JointType _joint1 )
+void Body::drawBone( JointType _joint0, JointType _joint1 ) const
 {
   if( !is_tracked ) return;
 
@@ -1150,7 +1202,7 @@ void Body::drawBone( JointType _joint0, JointType _joint1 )
 
 // Body::drawHands
 //----------------------------------------------------------
-void Body::drawHands()
+void Body::drawHands() const
 {
   drawHandLeft();
   drawHandRight();
@@ -1158,7 +1210,7 @@ void Body::drawHands()
 
 // Body::drawHandLeft
 //----------------------------------------------------------
-void Body::drawHandLeft()
+void Body::drawHandLeft() const
 {
   if( !is_tracked ) return;
 
@@ -1180,123 +1232,643 @@ void Body::drawHandLeft()
     }
     ofEllipse( jointToScreen( JointType_HandLeft ), 30, 30 );
   }
-  ofPopStyle();
+  ofPopStyle();
+}
+
+// Body::drawHandRight
+//----------------------------------------------------------
+void Body::drawHandRight() const
+{
+  if( !is_tracked ) return;
+
+  ofPushStyle();
+  {
+    switch( right_hand_state )
+    {
+    case HandState_Closed:
+      ofSetColor( ofColor::red );
+      break;
+
+    case HandState_Open:
+      ofSetColor( ofColor::green );
+      break;
+
+    case HandState_Lasso:
+      ofSetColor( ofColor::blue );
+      break;
+    }
+    ofEllipse( jointToScreen( JointType_HandRight ), 30, 30 );
+  }
+  ofPopStyle();
+}
+
+// Body::drawLean
+//----------------------------------------------------------
+void Body::drawLean() const
+{
+  if( !is_tracked ) return;
+
+  if( lean_state == TrackingState_Tracked )
+  {
+    ofPushStyle();
+    {
+      ofSetColor( ofColor::magenta );
+      ofLine( jointToScreen( JointType_SpineBase ), jointToScreen( JointType_SpineBase ) + body_lean );
+    }
+    ofPopStyle();
+  }
+}
+
+
+
+
+
+
+// BodyStream::acquire
+//----------------------------------------------------------
+HRESULT BodyStream::acquire( IBodyFrame* _p_frame )
+{
+  Vector4 floor = { 0 };
+  HRESULT hr    = _p_frame->get_FloorClipPlane( &floor );
+  body_frame.floor_clip_plane.set( floor.x, floor.y, floor.z, floor.w );
+
+  IBody* ppBodies[ BODY_COUNT ] = { 0 };
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_frame->GetAndRefreshBodyData( _countof( ppBodies ), ppBodies );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    int i = 0;
+    for( auto b : ppBodies )
+    {
+      BOOLEAN tracked = false;
+
+      if( b )
+      {
+        b->get_IsTracked( &tracked );
+
+        UINT64 id = -1;
+        b->get_TrackingId( &id );
+        
+        body_frame.bodies[ i ].setTracked( ( bool )tracked );
+        body_frame.bodies[ i ].setId( id );
+        
+        if( tracked ) body_frame.bodies[ i ].update( b );
+      }
+
+      ++i;
+    }
+
+    for( auto b : ppBodies ) safe_release( b );
+
+    body_frame.timestamp = frame.timestamp;
+    detectEvents();
+    filterJoints();
+    projectJoints();
+    extractHandCrops();
+    updateHistory();
+    recognizeGestures();
+
+    body_frame.buildIndex();
+    publishSnapshot();
+  }
+
+  return hr;
+}
+
+// BodyStream::publishSnapshot
+//----------------------------------------------------------
+void BodyStream::publishSnapshot()
+{
+  shared_ptr< BodyFrame > p_frame = snapshot_pool.acquire();
+  *p_frame = body_frame;
+  std::atomic_store( &snapshot, BodyFrame::Ref( p_frame ) );
+}
+
+// BodyStream::filterJoints
+//----------------------------------------------------------
+void BodyStream::filterJoints()
+{
+  if( joint_filter.getType() == JOINT_FILTER_NONE ) return;
+
+  for( int b = 0; b < BODY_COUNT; ++b )
+  {
+    Body& body = body_frame.bodies[ b ];
+
+    // a new person in the slot starts from scratch
+    if( body.id != filter_ids[ b ] )
+    {
+      joint_filter.reset( b * JointType_Count, ( b + 1 ) * JointType_Count );
+      filter_ids[ b ] = body.id;
+    }
+
+    for( int j = 0; j < JointType_Count; ++j )
+    {
+      const Joint& joint = body.joints[ j ];
+      bool         valid = body.is_tracked && joint.TrackingState != TrackingState_NotTracked;
+      joint_filter.set( b * JointType_Count + j, joint.Position.X, joint.Position.Y, joint.Position.Z, valid );
+    }
+  }
+
+  // relative time is in 100ns ticks
+  float dt         = filter_timestamp ? ( body_frame.timestamp - filter_timestamp ) * 1e-7f : 0;
+  filter_timestamp = body_frame.timestamp;
+  joint_filter.apply( dt );
+
+  for( int b = 0; b < BODY_COUNT; ++b )
+  {
+    Body& body = body_frame.bodies[ b ];
+    if( !body.is_tracked ) continue;
+
+    for( int j = 0; j < JointType_Count; ++j )
+    {
+      int               i = b * JointType_Count + j;
+      CameraSpacePoint& p = body.joints[ j ].Position;
+      p.X = joint_filter.get( i, 0 );
+      p.Y = joint_filter.get( i, 1 );
+      p.Z = joint_filter.get( i, 2 );
+    }
+  }
+}
+
+// BodyStream::updateHistory
+//----------------------------------------------------------
+void BodyStream::updateHistory()
+{
+  if( history.getCapacity() == 0 ) return;
+
+  for( int b = 0; b < BODY_COUNT; ++b )
+  {
+    const Body& body = body_frame.bodies[ b ];
+    if( body.is_tracked ) history.push( b, body.id, body_frame.timestamp, body.joints );
+    else                  history.clear( b );
+  }
+}
+
+// BodyStream::detectEvents
+//----------------------------------------------------------
+void BodyStream::detectEvents()
+{
+  for( int b = 0; b < BODY_COUNT; ++b )
+  {
+    const Body& body = body_frame.bodies[ b ];
+    UINT64      id   = body.is_tracked ? body.id : 0;
+
+    if( id != event_ids[ b ] )
+    {
+      if( event_ids[ b ] ) pushEvent( BODY_EVENT_LEAVE, b, event_ids[ b ] );
+      if( id )             pushEvent( BODY_EVENT_ENTER, b, id );
+
+      event_ids[ b ]          = id;
+      event_left_states[ b ]  = HandState_Unknown;
+      event_right_states[ b ] = HandState_Unknown;
+    }
+    if( !id ) continue;
+
+    if( body.left_hand_state != event_left_states[ b ] )
+    {
+      pushEvent( BODY_EVENT_HAND_LEFT, b, id, body.left_hand_state, event_left_states[ b ] );
+      event_left_states[ b ] = body.left_hand_state;
+    }
+    if( body.right_hand_state != event_right_states[ b ] )
+    {
+      pushEvent( BODY_EVENT_HAND_RIGHT, b, id, body.right_hand_state, event_right_states[ b ] );
+      event_right_states[ b ] = body.right_hand_state;
+    }
+  }
+}
+
+// BodyStream::pushEvent
+//----------------------------------------------------------
+void BodyStream::pushEvent( BodyEventType _type, int _slot, UINT64 _id, HandState _state, HandState _previous )
+{
+  BodyEvent e;
+  e.type                = _type;
+  e.slot                = _slot;
+  e.id                  = _id;
+  e.timestamp           = body_frame.timestamp;
+  e.hand_state          = _state;
+  e.previous_hand_state = _previous;
+
+  // a stalled main thread loses the newest events, not the reader thread
+  if( !events.push( e ) ) ofLogVerbose( "ofxKinect2::BodyStream" ) << "Body event queue full.";
+}
+
+// BodyStream::recognizeGestures
+//----------------------------------------------------------
+void BodyStream::recognizeGestures()
+{
+  if( !is_gestures_enabled ) return;
+
+  GestureEventArgs args;
+  for( int b = 0; b < BODY_COUNT; ++b )
+  {
+    const Body& body = body_frame.bodies[ b ];
+    if( !gestures.update( b, body.id, body.is_tracked, body.joints, body_frame.timestamp, args ) ) continue;
+
+    // delivered by notifyEvents() like the body events
+    if( !gesture_events.push( args ) ) ofLogVerbose( "ofxKinect2::BodyStream" ) << "Gesture event queue full.";
+  }
+}
+
+// BodyStream::setGestureJoints
+//----------------------------------------------------------
+void BodyStream::setGestureJoints( const vector< JointType >& _joints )
+{
+  if( lock() )
+  {
+    gestures.setJoints( _joints );
+    unlock();
+  }
+}
+
+// BodyStream::setGestureThreshold
+//----------------------------------------------------------
+void BodyStream::setGestureThreshold( float _threshold )
+{
+  if( lock() )
+  {
+    gestures.setThreshold( _threshold );
+    unlock();
+  }
+}
+
+// BodyStream::setGestureBand
+//----------------------------------------------------------
+void BodyStream::setGestureBand( float _band )
+{
+  if( lock() )
+  {
+    gestures.setBand( _band );
+    unlock();
+  }
+}
+
+// BodyStream::setGestureCooldown
+//----------------------------------------------------------
+void BodyStream::setGestureCooldown( int _frames )
+{
+  if( lock() )
+  {
+    gestures.setCooldown( _frames );
+    unlock();
+  }
+}
+
+// BodyStream::addGestureTemplate
+//----------------------------------------------------------
+void BodyStream::addGestureTemplate( const string& _name, const vector< float >& _frames )
+{
+  if( lock() )
+  {
+    gestures.addTemplate( _name, _frames );
+    unlock();
+  }
+}
+
+// BodyStream::removeGestureTemplates
+//----------------------------------------------------------
+void BodyStream::removeGestureTemplates( const string& _name )
+{
+  if( lock() )
+  {
+    gestures.removeTemplates( _name );
+    unlock();
+  }
+}
+
+// BodyStream::getNumGestureTemplates
+//----------------------------------------------------------
+size_t BodyStream::getNumGestureTemplates()
+{
+  size_t num = 0;
+  if( lock() )
+  {
+    num = gestures.getNumTemplates();
+    unlock();
+  }
+  return num;
+}
+
+// BodyStream::getGestureTemplateName
+//----------------------------------------------------------
+string BodyStream::getGestureTemplateName( size_t _i )
+{
+  string name;
+  if( lock() )
+  {
+    name = gestures.getTemplateName( _i );
+    unlock();
+  }
+  return name;
+}
+
+// BodyStream::startGestureRecording
+//----------------------------------------------------------
+void BodyStream::startGestureRecording( UINT64 _id )
+{
+  if( lock() )
+  {
+    gestures.startRecording( _id );
+    unlock();
+  }
+}
+
+// BodyStream::stopGestureRecording
+//----------------------------------------------------------
+void BodyStream::stopGestureRecording( const string& _name )
+{
+  if( lock() )
+  {
+    gestures.stopRecording( _name );
+    unlock();
+  }
+}
+
+// BodyStream::isGestureRecording
+//----------------------------------------------------------
+bool BodyStream::isGestureRecording()
+{
+  bool is_recording = false;
+  if( lock() )
+  {
+    is_recording = gestures.isRecording();
+    unlock();
+  }
+  return is_recording;
+}
+
+// BodyStream::saveGestures
+//----------------------------------------------------------
+bool BodyStream::saveGestures( const string& _path )
+{
+  bool is_saved = false;
+  if( lock() )
+  {
+    is_saved = gestures.save( _path );
+    unlock();
+  }
+  return is_saved;
+}
+
+// BodyStream::loadGestures
+//----------------------------------------------------------
+bool BodyStream::loadGestures( const string& _path )
+{
+  bool is_loaded = false;
+  if( lock() )
+  {
+    is_loaded = gestures.load( _path );
+    unlock();
+  }
+  return is_loaded;
+}
+
+// BodyStream::setHistorySize
+//----------------------------------------------------------
+void BodyStream::setHistorySize( int _num_frames )
+{
+  if( lock() )
+  {
+    history.setup( _num_frames );
+    unlock();
+  }
+}
+
+// BodyStream::getHistory
+//----------------------------------------------------------
+void BodyStream::getHistory( JointHistory& _history, int _num_frames )
+{
+  if( lock() )
+  {
+    _history.copyLatest( history, _num_frames );
+    unlock();
+  }
+}
+
+// BodyStream::setJointFilter
+//----------------------------------------------------------
+void BodyStream::setJointFilter( JointFilterType _type )
+{
+  if( lock() )
+  {
+    joint_filter.setType( _type );
+    unlock();
+  }
+}
+
+void BodyStream::setJointFilter( const DoubleExponentialParams& _params )
+{
+  if( lock() )
+  {
+    joint_filter.setParams( _params );
+    unlock();
+  }
+}
+
+void BodyStream::setJointFilter( const OneEuroParams& _params )
+{
+  if( lock() )
+  {
+    joint_filter.setParams( _params );
+    unlock();
+  }
 }
 
-// Body::drawHandRight
+// BodyStream::projectJoints
 //----------------------------------------------------------
-void Body::drawHandRight()
+void BodyStream::projectJoints()
 {
-  if( !is_tracked ) return;
+  if( !p_mapper ) return;
 
-  ofPushStyle();
+  const int   stride = JointType_Count + 3;
+  const float edge   = hand_crop_meters * 0.5f;
+  UINT        n      = 0;
+  for( auto& b : body_frame.bodies )
   {
-    switch( right_hand_state )
-    {
-    case HandState_Closed:
-      ofSetColor( ofColor::red );
-      break;
-
-    case HandState_Open:
-      ofSetColor( ofColor::green );
-      break;
+    if( !b.is_tracked ) continue;
 
-    case HandState_Lasso:
-      ofSetColor( ofColor::blue );
-      break;
+    for( int j = 0; j < JointType_Count; ++j )
+    {
+      camera_points[ n++ ] = b.joints[ j ].Position;
     }
-    ofEllipse( jointToScreen( JointType_HandRight ), 30, 30 );
+    camera_points[ n ].X = b.lean.X;
+    camera_points[ n ].Y = b.lean.Y;
+    camera_points[ n ].Z = 0;
+    ++n;
+
+    // sideways by half the crop size, gives the crop radius in depth pixels
+    camera_points[ n ]      = b.joints[ JointType_HandLeft ].Position;
+    camera_points[ n++ ].X += edge;
+    camera_points[ n ]      = b.joints[ JointType_HandRight ].Position;
+    camera_points[ n++ ].X += edge;
   }
-  ofPopStyle();
-}
+  if( n == 0 ) return;
 
-// Body::drawLean
-//----------------------------------------------------------
-void Body::drawLean()
-{
-  if( !is_tracked ) return;
+  p_mapper->MapCameraPointsToColorSpace( n, camera_points, n, color_points );
+  p_mapper->MapCameraPointsToDepthSpace( n, camera_points, n, depth_points );
 
-  if( lean_state == TrackingState_Tracked )
+  int offset = 0;
+  for( int i = 0; i < BODY_COUNT; ++i )
   {
-    ofPushStyle();
+    Body& b = body_frame.bodies[ i ];
+    if( !b.is_tracked ) continue;
+
+    for( int j = 0; j < JointType_Count; ++j )
     {
-      ofSetColor( ofColor::magenta );
-      ofLine( jointToScreen( JointType_SpineBase ), jointToScreen( JointType_SpineBase ) + body_lean );
+      b.joint_points[ j ].set( color_points[ offset + j ].X, color_points[ offset + j ].Y, 0 );
+      b.joint_depth_points[ j ].set( depth_points[ offset + j ].X, depth_points[ offset + j ].Y, 0 );
     }
-    ofPopStyle();
+    b.body_lean.set( color_points[ offset + JointType_Count ].X, color_points[ offset + JointType_Count ].Y );
+
+    hand_crop_radii[ i ][ 0 ] = fabs( depth_points[ offset + JointType_Count + 1 ].X - depth_points[ offset + JointType_HandLeft ].X );
+    hand_crop_radii[ i ][ 1 ] = fabs( depth_points[ offset + JointType_Count + 2 ].X - depth_points[ offset + JointType_HandRight ].X );
+    offset += stride;
   }
 }
 
+// BodyStream::extractHandCrops
+//----------------------------------------------------------
+void BodyStream::extractHandCrops()
+{
+  if( !p_depth || !p_mapper ) return;
 
+  vector< HandCrop >& crops = hand_crops.getBackBuffer();
+  if( crops.size() != BODY_COUNT * 2 ) crops.resize( BODY_COUNT * 2 );
 
+  for( auto& c : crops )
+  {
+    if( c.pixels.getWidth() != hand_crop_size ) c.pixels.allocate( hand_crop_size, hand_crop_size, 1 );
+    c.is_valid = false;
+  }
 
+  // a zero copy handle is read under its own lock instead of the depth lock
+  FrameHandle::Ref      handle = p_depth->getFrameHandle();
+  const unsigned short* depth  = nullptr;
+  int                   dw     = 0;
+  int                   dh     = 0;
 
-
-// BodyStream::readFrame
-//----------------------------------------------------------
-bool BodyStream::readFrame()
-{
-  bool readed = false;
-  if( !stream.p_body_frame_reader )
+  if( handle )
   {
-    ofLogWarning( "ofxKinect2::BodyStream" ) << "Stream is not open.";
-    return readed;
+    handle->lock();
+    depth = handle->getData();
+    dw    = handle->getWidth();
+    dh    = handle->getHeight();
   }
+  else
+  {
+    if( !p_depth->lock() ) return;
 
-  IBodyFrame* p_frame = nullptr;
-  HRESULT     hr      = stream.p_body_frame_reader->AcquireLatestFrame( &p_frame );
+    // needs the full resolution GRAY16 output
+    const ofShortPixels& pixels = p_depth->getPixels();
+    if( pixels.getWidth() != p_depth->getWidth() )
+    {
+      p_depth->unlock();
+      return;
+    }
+    depth = pixels.getData();
+    dw    = pixels.getWidth();
+    dh    = pixels.getHeight();
+  }
 
-  if( SUCCEEDED( hr ) )
+  for( int b = 0; b < BODY_COUNT; ++b )
   {
-    hr = p_frame->get_RelativeTime( ( INT64* )&frame.timestamp );
+    const Body& body = body_frame.bodies[ b ];
+    if( !body.is_tracked ) continue;
 
-    IBody* ppBodies[ BODY_COUNT ] = { 0 };
-
-    if( SUCCEEDED( hr ) )
+    for( int h = 0; h < 2; ++h )
     {
-      hr = p_frame->GetAndRefreshBodyData( _countof( ppBodies ), ppBodies );
+      JointType joint = h == 0 ? JointType_HandLeft : JointType_HandRight;
+      HandCrop& c     = crops[ b * 2 + h ];
+
+      if( body.joints[ joint ].TrackingState == TrackingState_NotTracked ) continue;
+
+      c.slot      = b;
+      c.id        = body.id;
+      c.is_left   = h == 0;
+      c.state     = h == 0 ? body.left_hand_state : body.right_hand_state;
+      c.center    = body.joint_depth_points[ joint ];
+      c.depth     = body.joints[ joint ].Position.Z;
+      c.radius    = hand_crop_radii[ b ][ h ];
+      c.timestamp = body_frame.timestamp;
+      c.is_valid  = c.depth > 0 && c.radius >= 1;
+
+      if( c.is_valid ) sampleHandCrop( c, depth, dw, dh );
     }
+  }
 
-    if( SUCCEEDED( hr ) )
+  if( handle ) handle->unlock();
+  else         p_depth->unlock();
+  hand_crops.swap();
+}
+
+// BodyStream::sampleHandCrop
+//----------------------------------------------------------
+void BodyStream::sampleHandCrop( HandCrop& _crop, const unsigned short* _depth, int _width, int _height )
+{
+  const int             w     = _width;
+  const int             h     = _height;
+  const unsigned short* src   = _depth;
+  float*                dst   = _crop.pixels.getData();
+  const float           step  = _crop.radius * 2 / hand_crop_size;
+  const float           x0    = _crop.center.x - _crop.radius + step * 0.5f;
+  const float           y0    = _crop.center.y - _crop.radius + step * 0.5f;
+  const float           scale = 0.001f / ( hand_crop_meters * 0.5f );
+  const float           bias  = _crop.depth / ( hand_crop_meters * 0.5f );
+
+  for( int py = 0; py < hand_crop_size; ++py )
+  {
+    int sy = ( int )floor( y0 + py * step );
+    for( int px = 0; px < hand_crop_size; ++px, ++dst )
     {
-      int i = 0;
-      for( auto b : ppBodies )
+      int sx = ( int )floor( x0 + px * step );
+      if( sx < 0 || sy < 0 || sx >= w || sy >= h || !src[ sy * w + sx ] )
       {
-        BOOLEAN tracked = false;
-
-        if( b )
-        {
-          b->get_IsTracked( &tracked );
-
-          UINT64 id = -1;
-          b->get_TrackingId( &id );
-          
-          bodies[ i ].setTracked( ( bool )tracked );
-          bodies[ i ].setId( id );
-          
-          if( tracked ) bodies[ i ].update( b );
-        }
-
-        ++i;
+        *dst = 1;
+        continue;
       }
-
-      for( auto b : ppBodies ) safe_release( b );
-
-      readed = true;
-      setPixels( frame );
+      *dst = ofClamp( src[ sy * w + sx ] * scale - bias, -1, 1 );
     }
   }
+}
 
-  safe_release( p_frame );
+// BodyStream::setDepth
+//----------------------------------------------------------
+void BodyStream::setDepth( DepthStream& _depth )
+{
+  if( lock() )
+  {
+    if( p_depth != &_depth )
+    {
+      if( p_depth ) p_depth->releaseRawPixels();
+      _depth.retainRawPixels();
+    }
+    p_depth = &_depth;
+    unlock();
+  }
+}
 
-  return readed;
+// BodyStream::setHandCropSize
+//----------------------------------------------------------
+void BodyStream::setHandCropSize( int _pixels, float _meters )
+{
+  if( lock() )
+  {
+    hand_crop_size   = max( 1, _pixels );
+    hand_crop_meters = _meters;
+    unlock();
+  }
 }
 
 // BodyStream::draw
 //----------------------------------------------------------
 void BodyStream::draw()
 {
-  for( auto& b : bodies )
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies )
   {
     b.drawBody();
     b.drawHands();
@@ -1308,47 +1880,53 @@ void BodyStream::draw()
 //----------------------------------------------------------
 void BodyStream::drawBody()
 {
-  for( auto& b : bodies ) b.drawBody();
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies ) b.drawBody();
 }
 
 // BodyStream::drawBone
 //----------------------------------------------------------
 void BodyStream::drawBone( JointType _joint0, JointType _joint1 )
 {
-  for( auto& b : bodies ) b.drawBone( _joint0, _joint1 );
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies ) b.drawBone( _joint0, _joint1 );
 }
 
 // BodyStream::drawHands
 //----------------------------------------------------------
 void BodyStream::drawHands()
 {
-  for( auto& b : bodies ) b.drawHands();
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies ) b.drawHands();
 }
 
 // BodyStream::drawHandLeft
 //----------------------------------------------------------
 void BodyStream::drawHandLeft()
 {
-  for( auto& b : bodies ) b.drawHandLeft();
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies ) b.drawHandLeft();
 }
 
 // BodyStream::drawHandRight
 //----------------------------------------------------------
 void BodyStream::drawHandRight()
 {
-  for( auto& b : bodies ) b.drawHandRight();
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies ) b.drawHandRight();
 }
 
 // BodyStream::drawLean
 //----------------------------------------------------------
 void BodyStream::drawLean()
 {
-  for( auto& b : bodies ) b.drawLean();
+  BodyFrame::Ref f = getFrame();
+  for( auto& b : f->bodies ) b.drawLean();
 }
 
 // BodyStream::setPixels
 //----------------------------------------------------------
-void BodyStream::setPixels( Frame _frame )
+void BodyStream::setPixels( const Frame& _frame )
 {
   Stream::updateTimestamp( _frame );
 }
@@ -1364,40 +1942,29 @@ void BodyStream::update()
   }
 }
 
-// BodyStream::open
+// BodyStream::notifyEvents
 //----------------------------------------------------------
-bool BodyStream::open()
+void BodyStream::notifyEvents()
 {
-  if( !device->isOpen() )
-  {
-    ofLogWarning( "ofxKinect2::BodyStream" ) << "No ready Kinect2 found.";
-    return false;
-  }
-
-  IBodyFrameSource* p_source = nullptr;
-  HRESULT           hr       = device->get().kinect2->get_BodyFrameSource( &p_source );
-
-  if( SUCCEEDED( hr ) )
-  {
-    hr = p_source->OpenReader( &stream.p_body_frame_reader );
-  }
+  BodyEvent e;
+  while( events.pop( e ) ) ofNotifyEvent( body_event, e, this );
 
-  safe_release( p_source );
-  if( FAILED( hr ) )
-  {
-    ofLogWarning( "ofxKinect2::BodyStream" ) << "Can't open stream.";
-    return false;
-  }
+  GestureEventArgs g;
+  while( gesture_events.pop( g ) ) ofNotifyEvent( gesture_recognized, g, this );
+}
 
-  return Stream::open();
+// BodyStream::openSource
+//----------------------------------------------------------
+HRESULT BodyStream::openSource( IBodyFrameSource* _p_source )
+{
+  return device->get().kinect2->get_CoordinateMapper( &p_mapper );
 }
 
-// BodyStream::close
+// BodyStream::closeSource
 //----------------------------------------------------------
-void BodyStream::close()
+void BodyStream::closeSource()
 {
-  Stream::close();
-  safe_release( stream.p_body_frame_reader );
+  safe_release( p_mapper );
 }
 
 // BodyStream::
@@ -1422,6 +1989,312 @@ const ofShortPixels& BodyStream::getPixels( int _near, int _far, bool _invert )
 
 
 
+// SkeletonRenderer::bones
+//----------------------------------------------------------
+const JointType SkeletonRenderer::bones[ SkeletonRenderer::num_bones ][ 2 ] =
+{
+  { JointType_Head,          JointType_Neck },
+  { JointType_Neck,          JointType_SpineShoulder },
+  { JointType_SpineShoulder, JointType_SpineMid },
+  { JointType_SpineMid,      JointType_SpineBase },
+  { JointType_SpineShoulder, JointType_ShoulderLeft },
+  { JointType_SpineShoulder, JointType_ShoulderRight },
+  { JointType_SpineBase,     JointType_HipLeft },
+  { JointType_SpineBase,     JointType_HipRight },
+
+  { JointType_ShoulderLeft,  JointType_ElbowLeft },
+  { JointType_ElbowLeft,     JointType_WristLeft },
+  { JointType_WristLeft,     JointType_HandLeft },
+  { JointType_HandLeft,      JointType_HandTipLeft },
+  { JointType_WristLeft,     JointType_ThumbLeft },
+
+  { JointType_ShoulderRight, JointType_ElbowRight },
+  { JointType_ElbowRight,    JointType_WristRight },
+  { JointType_WristRight,    JointType_HandRight },
+  { JointType_HandRight,     JointType_HandTipRight },
+  { JointType_WristRight,    JointType_ThumbRight },
+
+  { JointType_HipLeft,       JointType_KneeLeft },
+  { JointType_KneeLeft,      JointType_AnkleLeft },
+  { JointType_AnkleLeft,     JointType_FootLeft },
+
+  { JointType_HipRight,      JointType_KneeRight },
+  { JointType_KneeRight,     JointType_AnkleRight },
+  { JointType_AnkleRight,    JointType_FootRight }
+};
+
+// SkeletonRenderer::build
+//----------------------------------------------------------
+void SkeletonRenderer::build( const BodyFrame& _frame )
+{
+  num_line_vertices     = 0;
+  num_triangle_vertices = 0;
+
+  const ofFloatColor tracked  = ofColor::green;
+  const ofFloatColor inferred = ofColor::gray;
+  const ofFloatColor joint    = ofColor( 50, 200, 50 );
+  const ofFloatColor lean     = ofColor::magenta;
+
+  for( auto& body : _frame.bodies )
+  {
+    if( !body.isTracked() ) continue;
+
+    // same rules as Body::drawBone
+    for( auto& bone : bones )
+    {
+      TrackingState state0 = body.getJoint( bone[ 0 ] ).TrackingState;
+      TrackingState state1 = body.getJoint( bone[ 1 ] ).TrackingState;
+
+      if( ( state0 == TrackingState_NotTracked ) || ( state1 == TrackingState_NotTracked ) ) continue;
+      if( ( state0 == TrackingState_Inferred )   && ( state1 == TrackingState_Inferred ) )   continue;
+
+      bool both = ( state0 == TrackingState_Tracked ) && ( state1 == TrackingState_Tracked );
+      addLine( body.getJointPoint( bone[ 0 ] ), body.getJointPoint( bone[ 1 ] ), both ? tracked : inferred );
+    }
+
+    if( body.getLeanState() == TrackingState_Tracked )
+    {
+      const ofPoint& base = body.getJointPoint( JointType_SpineBase );
+      addLine( base, base + body.getLean(), lean );
+    }
+
+    for( int j = 0; j < JointType_Count; ++j )
+    {
+      if( body.getJoint( j ).TrackingState == TrackingState_Tracked ) addQuad( body.getJointPoint( j ), joint_size, joint );
+    }
+
+    addHand( body.getJointPoint( JointType_HandLeft ), body.getLeftHandState() );
+    addHand( body.getJointPoint( JointType_HandRight ), body.getRightHandState() );
+  }
+}
+
+// SkeletonRenderer::addLine
+//----------------------------------------------------------
+void SkeletonRenderer::addLine( const ofVec3f& _p0, const ofVec3f& _p1, const ofFloatColor& _color )
+{
+  vertices[ num_line_vertices ] = _p0;
+  colors[ num_line_vertices++ ] = _color;
+  vertices[ num_line_vertices ] = _p1;
+  colors[ num_line_vertices++ ] = _color;
+}
+
+// SkeletonRenderer::addQuad
+//----------------------------------------------------------
+void SkeletonRenderer::addQuad( const ofVec3f& _center, float _size, const ofFloatColor& _color )
+{
+  float   h      = _size * 0.5f;
+  ofVec3f p[ 6 ] = { _center + ofVec3f( -h, -h ), _center + ofVec3f( h, -h ), _center + ofVec3f( h, h ),
+                     _center + ofVec3f( -h, -h ), _center + ofVec3f( h, h ),  _center + ofVec3f( -h, h ) };
+  int     i      = max_line_vertices + num_triangle_vertices;
+
+  for( int k = 0; k < 6; ++k )
+  {
+    vertices[ i + k ] = p[ k ];
+    colors[ i + k ]   = _color;
+  }
+  num_triangle_vertices += 6;
+}
+
+// SkeletonRenderer::addHand
+//----------------------------------------------------------
+void SkeletonRenderer::addHand( const ofVec3f& _center, HandState _state )
+{
+  ofFloatColor color;
+  switch( _state )
+  {
+  case HandState_Closed:
+    color = ofColor::red;
+    break;
+
+  case HandState_Open:
+    color = ofColor::green;
+    break;
+
+  case HandState_Lasso:
+    color = ofColor::blue;
+    break;
+
+  default:
+    return;
+  }
+
+  float r = hand_size * 0.5f;
+  int   i = max_line_vertices + num_triangle_vertices;
+  for( int k = 0; k < hand_segments; ++k, i += 3 )
+  {
+    vertices[ i + 0 ] = _center;
+    vertices[ i + 1 ] = _center + circle[ k ] * r;
+    vertices[ i + 2 ] = _center + circle[ k + 1 ] * r;
+    colors[ i + 0 ]   = colors[ i + 1 ] = colors[ i + 2 ] = color;
+  }
+  num_triangle_vertices += hand_segments * 3;
+}
+
+// SkeletonRenderer::update
+//----------------------------------------------------------
+void SkeletonRenderer::update()
+{
+  if( !is_vbo_allocated )
+  {
+    vbo.setVertexData( vertices, max_vertices, GL_DYNAMIC_DRAW );
+    vbo.setColorData( colors, max_vertices, GL_DYNAMIC_DRAW );
+    is_vbo_allocated = true;
+    return;
+  }
+
+  // both regions are fixed, upload up to the end of the used triangles
+  int n = num_triangle_vertices ? max_line_vertices + num_triangle_vertices : num_line_vertices;
+  vbo.updateVertexData( vertices, n );
+  vbo.updateColorData( colors, n );
+}
+
+// SkeletonRenderer::draw
+//----------------------------------------------------------
+void SkeletonRenderer::draw()
+{
+  if( !is_vbo_allocated ) return;
+
+  if( num_line_vertices )     vbo.draw( GL_LINES, 0, num_line_vertices );
+  if( num_triangle_vertices ) vbo.draw( GL_TRIANGLES, max_line_vertices, num_triangle_vertices );
+}
+
+// SkeletonRenderer::draw
+//----------------------------------------------------------
+void SkeletonRenderer::draw( const BodyStream& _stream )
+{
+  build( *_stream.getFrame() );
+  update();
+  draw();
+}
+
+
+
+
+
+
+// AudioStream::acquire
+//----------------------------------------------------------
+HRESULT AudioStream::acquire( IAudioBeamFrameList* _p_frame_list )
+{
+  UINT    num_beams = 0;
+  HRESULT hr        = _p_frame_list->get_BeamCount( &num_beams );
+  if( SUCCEEDED( hr ) && num_beams == 0 ) hr = E_FAIL;
+
+  // the sensor forms a single beam
+  IAudioBeamFrame* p_beam_frame = nullptr;
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_frame_list->OpenAudioBeamFrame( 0, &p_beam_frame );
+  }
+
+  UINT num_sub_frames = 0;
+  if( SUCCEEDED( hr ) )
+  {
+    hr = p_beam_frame->get_SubFrameCount( &num_sub_frames );
+  }
+
+  for( UINT i = 0; SUCCEEDED( hr ) && i < num_sub_frames; ++i )
+  {
+    IAudioBeamSubFrame* p_sub_frame = nullptr;
+    hr = p_beam_frame->GetSubFrame( i, &p_sub_frame );
+
+    if( SUCCEEDED( hr ) )
+    {
+      hr = readSubFrame( p_sub_frame );
+    }
+
+    safe_release( p_sub_frame );
+  }
+
+  safe_release( p_beam_frame );
+
+  return hr;
+}
+
+// AudioStream::readSubFrame
+//----------------------------------------------------------
+HRESULT AudioStream::readSubFrame( IAudioBeamSubFrame* _p_sub_frame )
+{
+  AudioBeam beam;
+  UINT      num_bytes = 0;
+  BYTE*     p_buffer  = nullptr;
+  HRESULT   hr        = _p_sub_frame->AccessUnderlyingBuffer( &num_bytes, &p_buffer );
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_sub_frame->get_BeamAngle( &beam.angle );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_sub_frame->get_BeamAngleConfidence( &beam.confidence );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    hr = _p_sub_frame->get_RelativeTime( ( INT64* )&beam.timestamp );
+  }
+
+  if( SUCCEEDED( hr ) )
+  {
+    const int num_samples = ( int )( num_bytes / sizeof( float ) );
+
+    beam.sample_position = sample_position;
+    sample_position     += num_samples;
+    frame.timestamp      = beam.timestamp;
+
+    samples.push( reinterpret_cast< const float* >( p_buffer ), num_samples );
+    beams.push( beam );
+    beam_angle.store( beam.angle );
+    beam_confidence.store( beam.confidence );
+  }
+
+  return hr;
+}
+
+// AudioStream::setPixels
+//----------------------------------------------------------
+void AudioStream::setPixels( const Frame& _frame )
+{
+  Stream::updateTimestamp( _frame );
+}
+
+// AudioStream::update
+//----------------------------------------------------------
+void AudioStream::update()
+{
+  if( lock() )
+  {
+    Stream::update();
+    unlock();
+  }
+}
+
+// AudioStream::readSamples
+//----------------------------------------------------------
+int AudioStream::readSamples( float* _output, int _buffer_size, int _n_channels )
+{
+  const int n = ( int )samples.pop( _output, ( size_t )max( _buffer_size, 0 ) );
+
+  // spread the mono samples over the channels in place, back to front
+  if( _n_channels > 1 )
+  {
+    for( int i = n - 1; i >= 0; --i )
+    {
+      const float v = _output[ i ];
+      for( int c = 0; c < _n_channels; ++c ) _output[ i * _n_channels + c ] = v;
+    }
+  }
+
+  std::fill( _output + n * _n_channels, _output + _buffer_size * _n_channels, 0.f );
+  return n;
+}
+
+
+
+
+
+
 // Mapper::setup
 //----------------------------------------------------------
 bool Mapper::setup( Device& _device )
@@ -1457,6 +2330,51 @@ bool Mapper::isReady( bool _depth, bool _color )
   return true;
 }
 
+// Mapper::getDepthFrameToCameraSpaceTable
+//----------------------------------------------------------
+const vector< ofVec2f >& Mapper::getDepthFrameToCameraSpaceTable()
+{
+  if( depth_to_camera_table.empty() ) queryDepthFrameToCameraSpaceTable( depth_to_camera_table );
+  return depth_to_camera_table;
+}
+
+// Mapper::queryDepthFrameToCameraSpaceTable
+//----------------------------------------------------------
+bool Mapper::queryDepthFrameToCameraSpaceTable( vector< ofVec2f >& _table ) const
+{
+  if( !p_mapper ) return false;
+
+  UINT32  table_size = 0;
+  PointF* table      = nullptr;
+  HRESULT hr         = p_mapper->GetDepthFrameToCameraSpaceTable( &table_size, &table );
+
+  // all zero until the sensor has started, keep asking instead of returning that
+  bool is_calibrated = false;
+  if( SUCCEEDED( hr ) && table )
+  {
+    for( UINT32 i = 0; i < table_size && !is_calibrated; ++i )
+    {
+      is_calibrated = table[ i ].X != 0 || table[ i ].Y != 0;
+    }
+
+    if( is_calibrated )
+    {
+      _table.resize( table_size );
+      for( UINT32 i = 0; i < table_size; ++i )
+      {
+        _table[ i ].set( table[ i ].X, table[ i ].Y );
+      }
+    }
+  }
+  else
+  {
+    ofLogWarning( "ofxKinect2::Mapper" ) << "Cannot get depth frame to camera space table.";
+  }
+
+  CoTaskMemFree( table );
+  return is_calibrated;
+}
+
 // Mapper::mapDepthToCameraSpace
 //----------------------------------------------------------
 ofVec3f Mapper::mapDepthToCameraSpace( int _x, int _y )
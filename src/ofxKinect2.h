@@ -2,7 +2,25 @@
 
 #include "ofMain.h"
 #include "ofxKinect2Types.h"
+#include "ofxKinect2Traits.h"
 #include "utils/DoubleBuffer.h"
+#include "utils/DepthMesh.h"
+#include "utils/DepthPyramid.h"
+#include "utils/HeightMap.h"
+#include "utils/PlaneEstimator.h"
+#include "utils/TouchDetector.h"
+#include "utils/MarkerDetector.h"
+#include "utils/JointFilter.h"
+#include "utils/JointHistory.h"
+#include "utils/GestureRecognizer.h"
+#include "utils/SpscQueue.h"
+#include "utils/SnapshotPool.h"
+#include "utils/BodyPointCloud.h"
+#include "utils/PixelConversion.h"
+#include "utils/ColorConversion.h"
+#include "utils/ColorResampler.h"
+#include "utils/FrameHandle.h"
+#include "utils/IrProcessing.h"
 
 
 // ofxKinect2
@@ -10,19 +28,33 @@
 namespace ofxKinect2
 {
   void  init();
+  // current time on the clock of the frame timestamps ( 100 ns ticks )
+  UINT64 getRelativeTime();
 
   class Device;
   class Stream;
+  template< class Derived, class Traits >
+  class StreamT;
+  template< class Derived, class Traits >
+  class IrStreamT;
   class Mapper;
 
   class ColorStream;
   class DepthStream;
   class IrStream;
+  class LongExposureIrStream;
   class BodyIndexStream;
 
   class Body;
+  struct BodyFrame;
+  struct BodyEvent;
+  struct HandCrop;
+  class SkeletonRenderer;
   class BodyStream;
 
+  struct AudioBeam;
+  class AudioStream;
+
   template< class Interface >
   inline void safe_release( Interface *& _p_release )
   {
@@ -100,6 +132,20 @@ public:
   // getter
   int                         getWidth() const;
   int                         getHeight() const;
+  const FrameDescription&     getFrameDescription() const { return description; }
+
+  // output format and integer downscale of getPixels(), before open()
+  bool                        setPixelFormat( PixelFormat _format );
+  inline PixelFormat          getPixelFormat() const { return frame.mode.pixel_format; }
+  bool                        setDownscale( int _factor );
+  inline int                  getDownscale() const { return downscale; }
+
+  // publish the raw 16 bit frame as a ref counted handle ( depth and ir ), before open().
+  // the handle holds the SDK frame until the next one arrives, handles kept longer are
+  // copied then, and up to _max_pooled of their buffers are recycled
+  bool                        setZeroCopy( bool _enabled, int _max_pooled = 2 );
+  inline bool                 isZeroCopy() const { return is_zero_copy; }
+  FrameHandle::Ref            getFrameHandle() const { return std::atomic_load( &frame_handle ); }
 
   inline bool                 isFrameNew() const { return is_frame_new; }
   inline uint64_t             getFrameTimestamp() const { return kinect2_timestamp; }
@@ -119,15 +165,39 @@ public:
 
 protected:
   Stream()
+    : downscale( 1 )
+    , device( nullptr )
+    , is_zero_copy( false )
+    , frame_arrived( 0 )
+    , is_frame_pending( false )
   {
+    // isOpen() and the setters called before setup() read these
+    stream.p_color_frame_reader             = nullptr;
+    camera_settings.p_color_camera_settings = nullptr;
   }
 
   void         threadedFunction();
   bool         setup( Device& _device, SensorType _sensor_type );
   virtual bool readFrame();
-  void         updateTimestamp( Frame _frame );
+  void         updateTimestamp( const Frame& _frame );
+
+  // called by open() before the thread starts, the per frame path only reads the payload
+  HRESULT      readFrameDescription( IFrameDescription* _p_description );
+  virtual bool isPixelFormatSupported( PixelFormat _format ) const { return false; }
+  virtual bool isZeroCopySupported() const { return false; }
+
+  // called by Device::update() on the main thread, delivers what the reader thread queued
+  virtual void notifyEvents() {}
+
+  // wraps _p_frame and points frame.data at the handle, takes over _p_frame
+  void         publishFrame( IUnknown* _p_frame );
+
+  // the full resolution GRAY16 output is the handle itself, getPixels() is not filled
+  bool         isPixelsFromHandle() const { return is_zero_copy && downscale == 1 && frame.mode.pixel_format == PIXEL_FORMAT_GRAY16; }
 
   Frame                frame;
+  FrameDescription     description;
+  int                  downscale;
   StreamHandle         stream;
   CameraSettingsHandle camera_settings;
   uint64_t             kinect2_timestamp, opengl_timestamp;
@@ -137,15 +207,171 @@ protected:
 
   ofTexture            tex;
   Device*              device;
+
+  bool                    is_zero_copy;
+  shared_ptr< FramePool > frame_pool;
+  FrameHandle::Ref        frame_handle;
+  WAITABLE_HANDLE         frame_arrived;
+  bool                    is_frame_pending;
+};
+
+
+// StreamT
+//   acquire, open and close of one sensor, fixed at compile time by Traits.
+//   Derived provides setPixels( const Frame& ) and may hide the hooks below,
+//   they are called without virtual dispatch.
+//--------------------------------------------------------------------------------
+template< class Derived, class Traits >
+class ofxKinect2::StreamT : public ofxKinect2::Stream
+{
+public:
+  bool open()
+  {
+    if( !device->isOpen() )
+    {
+      ofLogWarning( Traits::getName() ) << "No ready Kinect2 found.";
+      return false;
+    }
+
+    typename Traits::Source* p_source = nullptr;
+    HRESULT                  hr       = Traits::getSource( device->get().kinect2, &p_source );
+
+    if( SUCCEEDED( hr ) )
+    {
+      hr = p_source->OpenReader( &Traits::getReader( stream ) );
+    }
+
+    if( SUCCEEDED( hr ) && Traits::is_zero_copy_supported && is_zero_copy )
+    {
+      hr = Traits::subscribeFrameArrived( Traits::getReader( stream ), &frame_arrived );
+    }
+
+    IFrameDescription* p_frame_description = nullptr;
+    if( SUCCEEDED( hr ) )
+    {
+      hr = Traits::getFrameDescription( p_source, &p_frame_description );
+    }
+
+    if( SUCCEEDED( hr ) && p_frame_description )
+    {
+      hr = readFrameDescription( p_frame_description );
+    }
+
+    if( SUCCEEDED( hr ) )
+    {
+      hr = derived().openSource( p_source );
+    }
+
+    safe_release( p_frame_description );
+    safe_release( p_source );
+    if( FAILED( hr ) )
+    {
+      ofLogWarning( Traits::getName() ) << "Can't open stream.";
+      derived().closeSource();
+      unsubscribeFrameArrived();
+      safe_release( Traits::getReader( stream ) );
+      return false;
+    }
+
+    return Stream::open();
+  }
+
+  void close()
+  {
+    Stream::close();
+    unsubscribeFrameArrived();
+    safe_release( Traits::getReader( stream ) );
+    derived().closeSource();
+  }
+
+protected:
+  StreamT() : Stream()
+  {
+  }
+
+  bool readFrame()
+  {
+    bool                     readed   = false;
+    typename Traits::Reader* p_reader = Traits::getReader( stream );
+    if( !p_reader )
+    {
+      ofLogWarning( Traits::getName() ) << "Stream is not open.";
+      return readed;
+    }
+
+    // the reader hands out the next frame only once the held one is released.
+    // nobody can get the published handle once it is taken out, a handle still
+    // held by consumers is copied and stays published until the next acquire succeeds
+    if( Traits::is_zero_copy_supported && is_zero_copy )
+    {
+      if( !is_frame_pending && !Traits::isFrameArrived( p_reader, frame_arrived ) ) return readed;
+      is_frame_pending = true;
+
+      FrameHandle::Ref held = std::atomic_exchange( &frame_handle, FrameHandle::Ref() );
+      if( held && held.use_count() > 1 )
+      {
+        frame_pool->detach( held );
+        std::atomic_store( &frame_handle, held );
+      }
+    }
+
+    typename Traits::FrameType* p_frame = nullptr;
+    HRESULT                     hr      = Traits::acquireLatestFrame( p_reader, &p_frame );
+
+    if( SUCCEEDED( hr ) )
+    {
+      hr = Traits::getTimestamp( p_frame, &frame.timestamp );
+
+      if( SUCCEEDED( hr ) )
+      {
+        hr = derived().acquire( p_frame );
+      }
+
+      if( SUCCEEDED( hr ) )
+      {
+        // the handle owns the frame from here on
+        if( Traits::is_zero_copy_supported && is_zero_copy )
+        {
+          publishFrame( p_frame );
+          p_frame          = nullptr;
+          is_frame_pending = false;
+        }
+        readed = true;
+        derived().setPixels( frame );
+      }
+    }
+
+    safe_release( p_frame );
+
+    return readed;
+  }
+
+  bool isZeroCopySupported() const { return Traits::is_zero_copy_supported; }
+
+  void unsubscribeFrameArrived()
+  {
+    if( !frame_arrived ) return;
+    Traits::unsubscribeFrameArrived( Traits::getReader( stream ), frame_arrived );
+    frame_arrived = 0;
+  }
+
+  // hooks, hidden by Derived where needed
+  HRESULT openSource( typename Traits::Source* _p_source ) { return S_OK; }
+  void    closeSource() {}
+  HRESULT acquire( typename Traits::FrameType* _p_frame ) { return Traits::access( _p_frame, frame ); }
+
+  Derived& derived() { return static_cast< Derived& >( *this ); }
 };
 
 
 // ColorStream
 //--------------------------------------------------------------------------------
-class ofxKinect2::ColorStream : public ofxKinect2::Stream
+class ofxKinect2::ColorStream : public ofxKinect2::StreamT< ofxKinect2::ColorStream, ofxKinect2::ColorTraits >
 {
+  friend class ofxKinect2::StreamT< ofxKinect2::ColorStream, ofxKinect2::ColorTraits >;
+
 public:
-  ColorStream() : Stream()
+  ColorStream() : StreamT()
   {
   }
 
@@ -155,15 +381,23 @@ public:
 
   bool setup( ofxKinect2::Device& _device )
   {
-    buffer = nullptr;
+    buffer                  = nullptr;
+    raw_format              = ColorImageFormat_None;
+    frame.mode.pixel_format = PIXEL_FORMAT_RGBA;
+    scale                   = 1;
+    scale_filter            = SCALE_FILTER_BOX;
+    crop.set( 0, 0, 0, 0 );
     return Stream::setup( _device, SENSOR_COLOR );
   }
 
-  bool open();
-  void close();
-
   void update();
 
+  // region of interest and scale, applied while converting. before open(), not with PIXEL_FORMAT_YUY2
+  bool               setCrop( const ofRectangle& _rect );
+  bool               setScale( float _scale, ScaleFilter _filter = SCALE_FILTER_BOX );
+  const ofRectangle& getCrop() const { return crop; }
+  inline float       getScale() const { return scale; }
+
   // getter
   ofColor         getColorAt( int _x, int _y );
   ofColor         getColorAt( ofVec2f color_point );
@@ -173,26 +407,45 @@ public:
   ofPixels&       getPixels() { return pix.getFrontBuffer(); }
   const ofPixels& getPixels() const { return pix.getFrontBuffer(); }
 
+  // Y plane, PIXEL_FORMAT_YUY2 only
+  ofPixels&       getLumaPixels() { return luma.getFrontBuffer(); }
+  const ofPixels& getLumaPixels() const { return luma.getFrontBuffer(); }
+
   int             getExposureTime();
   int             getFrameInterval();
   float           getGain();
   float           getGamma();
 
 protected:
-  bool readFrame();
-  void setPixels( Frame _frame );
+  void    setPixels( const Frame& _frame );
+  HRESULT openSource( IColorFrameSource* _p_source );
+  HRESULT acquire( IColorFrame* _p_frame );
+
+  // RGBA ( default ), BGRA, RGB, GRAY or YUY2 ( raw, 2 channels, no downscale )
+  bool isPixelFormatSupported( PixelFormat _format ) const;
+
+  bool isResampled() const { return crop.width > 0 || scale != 1; }
 
   DoubleBuffer< ofPixels > pix;
+  DoubleBuffer< ofPixels > luma;
   unsigned char*           buffer;
+  ColorImageFormat         raw_format;
+
+  ofRectangle              crop;
+  float                    scale;
+  ScaleFilter              scale_filter;
+  ColorResampler           resampler;
 };
 
 
 // DepthStream
 //--------------------------------------------------------------------------------
-class ofxKinect2::DepthStream : public ofxKinect2::Stream
+class ofxKinect2::DepthStream : public ofxKinect2::StreamT< ofxKinect2::DepthStream, ofxKinect2::DepthTraits >
 {
+  friend class ofxKinect2::StreamT< ofxKinect2::DepthStream, ofxKinect2::DepthTraits >;
+
 public:
-  DepthStream() : Stream()
+  DepthStream() : StreamT()
   {
   }
 
@@ -202,14 +455,17 @@ public:
 
   bool setup( ofxKinect2::Device& _device )
   {
-    near_value = 50;
-    far_value  = 10000;
+    near_value              = 50;
+    far_value               = 10000;
+    is_invert               = false;
+    min_reliable_distance   = 0;
+    max_reliable_distance   = 0;
+    is_touch_enabled        = false;
+    num_raw_users           = 0;
+    frame.mode.pixel_format = PIXEL_FORMAT_GRAY16;
     return Stream::setup( _device, SENSOR_DEPTH );
   }
 
-  bool open();
-  void close();
-
   void update();
   
   // setter
@@ -221,33 +477,258 @@ public:
   unsigned short       getDepthAt( int _x, int _y );
   unsigned short       getDepthAt( ofVec2f depth_point );
 
+  // raw millimeters with GRAY16, with GRAY and FLOAT only while retained or with a pyramid.
+  // not filled in zero copy mode at full resolution GRAY16, use getFrameHandle()
   ofShortPixels&       getPixels() { return pix.getFrontBuffer(); }
   const ofShortPixels& getPixels() const { return pix.getFrontBuffer(); }
 
   ofShortPixels&       getPixels( int _near, int _far, bool invert = false );
   const ofShortPixels& getPixels( int _near, int _far, bool invert = false ) const;
 
+  // consumers of the raw pixels next to a GRAY or FLOAT output, setDepth() of IrStream, BodyStream and Mapper retain them
+  void                 retainRawPixels(){ ++num_raw_users; }
+  void                 releaseRawPixels(){ --num_raw_users; }
+
+  // PIXEL_FORMAT_FLOAT, meters
+  ofFloatPixels&       getFloatPixels() { return float_pix.getFrontBuffer(); }
+  const ofFloatPixels& getFloatPixels() const { return float_pix.getFrontBuffer(); }
+
+  // PIXEL_FORMAT_GRAY, near to far as 0 to 255
+  ofPixels&            getCharPixels() { return char_pix.getFrontBuffer(); }
+  const ofPixels&      getCharPixels() const { return char_pix.getFrontBuffer(); }
+
   inline float         getFar() const { return far_value; }
   inline float         getNear() const { return near_value; }
   inline bool          getInvert() const { return is_invert; }
 
+  // reliable range of the sensor in millimeters, read at open()
+  unsigned short       getMinReliableDistance() const { return min_reliable_distance; }
+  unsigned short       getMaxReliableDistance() const { return max_reliable_distance; }
+
+  // pyramid, level 0 is the full resolution frame
+  void                 setPyramid( int _num_levels, DepthPyramidMode _mode = DEPTH_PYRAMID_MIN );
+  inline int           getNumPyramidLevels() const { return pyramid.getFrontBuffer().getNumLevels() + 1; }
+  const ofShortPixels& getPyramidLevel( int _level ) const;
+
+  // touch surface, detection runs on the reader thread. see TouchDetector
+  inline void          setTouchEnabled( bool _enabled ){ is_touch_enabled = _enabled; }
+  inline bool          isTouchEnabled() const { return is_touch_enabled; }
+  void                 learnTouchSurface( int _num_frames = 30 );
+  bool                 isTouchSurfaceLearned() const { return touch_detector.isSurfaceLearned(); }
+  void                 setTouchHeightBand( unsigned short _min_height, unsigned short _max_height );
+  void                 setTouchAreaRange( int _min_area, int _max_area );
+  void                 setTouchMaxDistance( float _max_distance );
+
+  // copies of the latest detection
+  void                 getTouches( vector< Touch >& _touches );
+  void                 getTouchMask( vector< unsigned char >& _mask );
+  void                 getTouchSurface( vector< unsigned short >& _surface );
+
+  // notified on the main thread by Device::update()
+  ofEvent< Touch >     touch_down;
+  ofEvent< Touch >     touch_moved;
+  ofEvent< Touch >     touch_up;
+
 protected:
-  bool readFrame();
-  void setPixels( Frame _frame );
+  void    setPixels( const Frame& _frame );
+  HRESULT openSource( IDepthFrameSource* _p_source );
+  void    notifyEvents();
+
+  // GRAY16 ( default, millimeters ), FLOAT or GRAY next to it. pyramid and touch always use the raw frame
+  bool isPixelFormatSupported( PixelFormat _format ) const;
 
   DoubleBuffer< ofShortPixels > pix;
+  DoubleBuffer< ofFloatPixels > float_pix;
+  DoubleBuffer< ofPixels >      char_pix;
+  DoubleBuffer< DepthPyramid >  pyramid;
   float                         near_value;
   float                         far_value;
   bool                          is_invert;
+  unsigned short                min_reliable_distance;
+  unsigned short                max_reliable_distance;
+
+  TouchDetector                 touch_detector;
+  bool                          is_touch_enabled;
+  std::atomic< int >            num_raw_users;
+};
+
+
+// IrStreamT
+//   pixel outputs and display mapping shared by the infrared streams.
+//   Derived may hide processRaw() to look at the raw frame on the reader thread.
+//--------------------------------------------------------------------------------
+template< class Derived, class Traits >
+class ofxKinect2::IrStreamT : public ofxKinect2::StreamT< Derived, Traits >
+{
+  friend class ofxKinect2::StreamT< Derived, Traits >;
+
+public:
+  void update()
+  {
+    const PixelFormat format = frame.mode.pixel_format;
+
+    if( !tex.isAllocated() )
+    {
+      tex.allocate( getWidth() / downscale, getHeight() / downscale, format == PIXEL_FORMAT_FLOAT ? GL_LUMINANCE32F_ARB : GL_LUMINANCE );
+    }
+
+    if( lock() )
+    {
+      FrameHandle::Ref handle = getFrameHandle();
+      if( format == PIXEL_FORMAT_GRAY )       tex.loadData( char_pix.getFrontBuffer() );
+      else if( format == PIXEL_FORMAT_FLOAT ) tex.loadData( float_pix.getFrontBuffer() );
+      else if( !isPixelsFromHandle() )        tex.loadData( pix.getFrontBuffer() );
+      else if( handle )                       tex.loadData( handle->getData(), handle->getWidth(), handle->getHeight(), GL_LUMINANCE );
+      Stream::update();
+      unlock();
+    }
+  }
+
+  // raw unless setNormalized(). not filled in zero copy mode at full resolution raw GRAY16, use getFrameHandle()
+  ofShortPixels&       getPixels() { return pix.getFrontBuffer(); }
+  const ofShortPixels& getPixels() const { return pix.getFrontBuffer(); }
+
+  // display mapping of FLOAT, GRAY and normalized GRAY16 output, see IrProcessing
+  void setRange( float _lo, float _hi )
+  {
+    if( lock() )
+    {
+      processing.setRange( _lo, _hi );
+      unlock();
+    }
+  }
+
+  void setGamma( float _gamma )
+  {
+    if( lock() )
+    {
+      processing.setGamma( _gamma );
+      unlock();
+    }
+  }
+
+  void setExposure( IrExposure _exposure, float _low = 0.01f, float _high = 0.99f, float _adaptation = 0.2f )
+  {
+    if( lock() )
+    {
+      processing.setExposure( _exposure, _low, _high, _adaptation );
+      unlock();
+    }
+  }
+
+  void setNormalized( bool _normalized )
+  {
+    if( lock() )
+    {
+      processing.setNormalizeShort( _normalized );
+      unlock();
+    }
+  }
+
+  void getHistogram( vector< unsigned int >& _histogram )
+  {
+    if( lock() )
+    {
+      _histogram = processing.getHistogram();
+      unlock();
+    }
+  }
+
+  const IrProcessing&  getProcessing() const { return processing; }
+
+  // PIXEL_FORMAT_FLOAT, range as 0 to 1
+  ofFloatPixels&       getFloatPixels() { return float_pix.getFrontBuffer(); }
+  const ofFloatPixels& getFloatPixels() const { return float_pix.getFrontBuffer(); }
+
+  // PIXEL_FORMAT_GRAY, range and gamma
+  ofPixels&            getCharPixels() { return char_pix.getFrontBuffer(); }
+  const ofPixels&      getCharPixels() const { return char_pix.getFrontBuffer(); }
+
+protected:
+  typedef ofxKinect2::StreamT< Derived, Traits > Base;
+  using Base::frame;
+  using Base::downscale;
+  using Base::tex;
+  using Base::lock;
+  using Base::unlock;
+  using Base::getWidth;
+  using Base::getHeight;
+  using Base::getFrameHandle;
+
+  IrStreamT() : Base()
+  {
+  }
+
+  bool setup( ofxKinect2::Device& _device, SensorType _sensor_type )
+  {
+    frame.mode.pixel_format = PIXEL_FORMAT_GRAY16;
+    return Stream::setup( _device, _sensor_type );
+  }
+
+  void setPixels( const Frame& _frame )
+  {
+    Stream::updateTimestamp( _frame );
+
+    const unsigned short *pixels = ( const unsigned short* )_frame.data;
+    if( !pixels ) return;
+
+    int w = _frame.width;
+    int h = _frame.height;
+
+    switch( _frame.mode.pixel_format )
+    {
+    case PIXEL_FORMAT_FLOAT:
+      float_pix.allocate( w / downscale, h / downscale, 1 );
+      processing.convertToFloat( pixels, float_pix.getBackBuffer().getData(), w, h, downscale );
+      break;
+
+    case PIXEL_FORMAT_GRAY:
+      char_pix.allocate( w / downscale, h / downscale, 1 );
+      processing.convertToByte( pixels, char_pix.getBackBuffer().getData(), w, h, downscale );
+      break;
+
+    default:
+      if( isPixelsFromHandle() ) break;
+      pix.allocate( w / downscale, h / downscale, 1 );
+      if( processing.isNormalizingShort() ) processing.convertToShort( pixels, pix.getBackBuffer().getData(), w, h, downscale );
+      else                                  convertShort( pixels, pix.getBackBuffer().getData(), w, h, downscale, true );
+      break;
+    }
+
+    static_cast< Derived* >( this )->processRaw( pixels, w, h, _frame.timestamp );
+
+    pix.swap();
+    float_pix.swap();
+    char_pix.swap();
+  }
+
+  // hook, full resolution raw frame
+  void processRaw( const unsigned short* _pixels, int _width, int _height, UINT64 _timestamp ) {}
+
+  // GRAY16 ( default ), FLOAT or GRAY, box filtered when downscaled
+  bool isPixelFormatSupported( PixelFormat _format ) const
+  {
+    return _format == PIXEL_FORMAT_GRAY16 || _format == PIXEL_FORMAT_FLOAT || _format == PIXEL_FORMAT_GRAY;
+  }
+
+  bool isPixelsFromHandle() const { return Stream::isPixelsFromHandle() && !processing.isNormalizingShort(); }
+
+  DoubleBuffer< ofShortPixels > pix;
+  DoubleBuffer< ofFloatPixels > float_pix;
+  DoubleBuffer< ofPixels >      char_pix;
+  IrProcessing                  processing;
 };
 
 
 // IrStream
 //--------------------------------------------------------------------------------
-class ofxKinect2::IrStream : public ofxKinect2::Stream
+class ofxKinect2::IrStream : public ofxKinect2::IrStreamT< ofxKinect2::IrStream, ofxKinect2::IrTraits >
 {
+  friend class ofxKinect2::StreamT< ofxKinect2::IrStream, ofxKinect2::IrTraits >;
+  friend class ofxKinect2::IrStreamT< ofxKinect2::IrStream, ofxKinect2::IrTraits >;
+
 public:
-  IrStream() : Stream()
+  IrStream() : IrStreamT()
   {
   }
 
@@ -257,31 +738,70 @@ public:
 
   bool setup( ofxKinect2::Device& _device )
   {
-    return Stream::setup( _device, SENSOR_IR );
+    is_markers_enabled = false;
+    p_depth            = nullptr;
+    p_mapper           = nullptr;
+    return IrStreamT::setup( _device, SENSOR_IR );
   }
 
-  bool open();
-  void close();
+  // retroreflective markers, detection runs on the reader thread on the raw frame
+  inline void   setMarkersEnabled( bool _enabled ){ is_markers_enabled = _enabled; }
+  inline bool   isMarkersEnabled() const { return is_markers_enabled; }
+  // marker depth needs the depth stream, camera positions the mapper, fetched once the sensor is calibrated
+  void          setDepth( DepthStream& _depth, Mapper* _mapper = nullptr );
 
-  void update();
+  // see MarkerDetector
+  void          setMarkerThreshold( unsigned short _threshold );
+  void          setMarkerAreaRange( int _min_area, int _max_area );
+  void          setMarkerDepthRadius( int _radius );
 
-  ofShortPixels&       getPixels() { return pix.getFrontBuffer(); }
-  const ofShortPixels& getPixels() const { return pix.getFrontBuffer(); }
+  // copies of the latest detection
+  void          getMarkers( vector< Marker >& _markers );
+  void          getMarkerMask( vector< unsigned char >& _mask );
 
 protected:
-  bool readFrame();
-  void setPixels( Frame _frame );
+  void processRaw( const unsigned short* _pixels, int _width, int _height, UINT64 _timestamp );
 
-  DoubleBuffer< ofShortPixels > pix;
+  MarkerDetector                marker_detector;
+  bool                          is_markers_enabled;
+  DepthStream*                  p_depth;
+  Mapper*                       p_mapper;
+  vector< unsigned short >      depth_snapshot;
+};
+
+
+// LongExposureIrStream
+//   long exposure infrared, brighter and less noisy in low light
+//--------------------------------------------------------------------------------
+class ofxKinect2::LongExposureIrStream : public ofxKinect2::IrStreamT< ofxKinect2::LongExposureIrStream, ofxKinect2::LongExposureIrTraits >
+{
+  friend class ofxKinect2::StreamT< ofxKinect2::LongExposureIrStream, ofxKinect2::LongExposureIrTraits >;
+  friend class ofxKinect2::IrStreamT< ofxKinect2::LongExposureIrStream, ofxKinect2::LongExposureIrTraits >;
+
+public:
+  LongExposureIrStream() : IrStreamT()
+  {
+  }
+
+  ~LongExposureIrStream()
+  {
+  }
+
+  bool setup( ofxKinect2::Device& _device )
+  {
+    return IrStreamT::setup( _device, SENSOR_LONG_EXPOSURE_IR );
+  }
 };
 
 
 // BodyIndexStream
 //--------------------------------------------------------------------------------
-class ofxKinect2::BodyIndexStream : public ofxKinect2::Stream
+class ofxKinect2::BodyIndexStream : public ofxKinect2::StreamT< ofxKinect2::BodyIndexStream, ofxKinect2::BodyIndexTraits >
 {
+  friend class ofxKinect2::StreamT< ofxKinect2::BodyIndexStream, ofxKinect2::BodyIndexTraits >;
+
 public:
-  BodyIndexStream() : Stream()
+  BodyIndexStream() : StreamT()
   {
     colors[ 0 ] = ofColor::red;
     colors[ 1 ] = ofColor::green;
@@ -297,22 +817,32 @@ public:
 
   bool setup( ofxKinect2::Device& _device )
   {
+    frame.mode.pixel_format = PIXEL_FORMAT_RGBA;
+    is_index_pixels         = false;
     return Stream::setup( _device, SENSOR_BODY_INDEX );
   }
 
-  bool open();
-  void close();
-
   void update();
 
   ofPixels&       getPixels() { return pix.getFrontBuffer(); }
   const ofPixels& getPixels() const { return pix.getFrontBuffer(); }
 
+  // raw body index per depth pixel, 255 where there is no body. same as getPixels() with PIXEL_FORMAT_GRAY,
+  // filled next to the colors only while enabled
+  inline void     setIndexPixelsEnabled( bool _enabled ){ is_index_pixels = _enabled; }
+  inline bool     isIndexPixelsEnabled() const { return is_index_pixels; }
+  ofPixels&       getIndexPixels() { return frame.mode.pixel_format == PIXEL_FORMAT_GRAY ? pix.getFrontBuffer() : index_pix.getFrontBuffer(); }
+  const ofPixels& getIndexPixels() const { return frame.mode.pixel_format == PIXEL_FORMAT_GRAY ? pix.getFrontBuffer() : index_pix.getFrontBuffer(); }
+
 protected:
-  bool readFrame();
-  void setPixels( Frame _frame );
+  void setPixels( const Frame& _frame );
+
+  // RGBA ( default ) or RGB body colors, or GRAY for the raw indices. never filtered
+  bool isPixelFormatSupported( PixelFormat _format ) const;
 
   DoubleBuffer< ofPixels > pix;
+  DoubleBuffer< ofPixels > index_pix;
+  bool                     is_index_pixels;
   unsigned char*           buffer;
   ofColor                  colors[ BODY_COUNT ];
 };
@@ -332,49 +862,62 @@ public:
     , right_hand_state( HandState_Unknown )
     , is_tracked( false )
     , is_update_scale( false )
+    , id( 0 )
+    , lean_state( TrackingState_NotTracked )
   {
-    joints.resize( JointType_Count );
-    joint_points.resize( JointType_Count );
-  }
-
-  void setup( ofxKinect2::Device& _device )
-  {
-    device = &_device;
+    memset( joints, 0, sizeof( joints ) );
+    lean.X = lean.Y = 0;
   }
 
   void update( IBody* _body );
-  void drawBody();
-  void drawBone( JointType _joint0, JointType _joint1);
-  void drawHands();
-  void drawHandLeft();
-  void drawHandRight();
-  void drawLean();
+  void drawBody() const;
+  void drawBone( JointType _joint0, JointType _joint1 ) const;
+  void drawHands() const;
+  void drawHandLeft() const;
+  void drawHandRight() const;
+  void drawLean() const;
 
   void setId( UINT64 _id ){ id = _id; }
   void setTracked( bool _is_tracked){ is_tracked = _is_tracked; }
 
-  inline int              getId() const { return id;}
+  // synthetic or recorded bodies, BodyStream fills these from the sensor
+  void setJoint( size_t _idx, const Joint& _joint, const ofPoint& _point, const ofPoint& _depth_point )
+  {
+    joints[ _idx ]             = _joint;
+    joint_points[ _idx ]       = _point;
+    joint_depth_points[ _idx ] = _depth_point;
+  }
+  void setHandStates( HandState _left, HandState _right ){ left_hand_state = _left; right_hand_state = _right; }
+  void setLean( const ofVec2f& _lean, TrackingState _state ){ body_lean = _lean; lean_state = _state; }
+
+  inline UINT64           getId() const { return id;}
   inline bool             isTracked() const { return is_tracked;}
 
   inline HandState        getLeftHandState() const { return left_hand_state; }
-  inline HandState        getRightHandState() const { return left_hand_state; }
+  inline HandState        getRightHandState() const { return right_hand_state; }
 
-  inline size_t           getNumJoints(){ return JointType_Count; }
+  inline size_t           getNumJoints() const { return JointType_Count; }
 
-  const Joint&            getJoint( size_t _idx ){ return joints[ _idx ]; }
+  const Joint&            getJoint( size_t _idx ) const { return joints[ _idx ]; }
 
-  const ofPoint&          getJointPoint( size_t _idx ){ return joint_points[ _idx ]; }
-  const vector< ofPoint > getJointPoints(){ return joint_points; }
+  // color space
+  const ofPoint&          getJointPoint( size_t _idx ) const { return joint_points[ _idx ]; }
+  const vector< ofPoint > getJointPoints() const { return vector< ofPoint >( joint_points, joint_points + JointType_Count ); }
+
+  // depth space
+  const ofPoint&          getJointDepthPoint( size_t _idx ) const { return joint_depth_points[ _idx ]; }
+  const vector< ofPoint > getJointDepthPoints() const { return vector< ofPoint >( joint_depth_points, joint_depth_points + JointType_Count ); }
   
-  const ofVec2f&          getLean() { return body_lean; }
+  const ofVec2f&          getLean() const { return body_lean; }
+  inline TrackingState    getLeanState() const { return lean_state; }
 
 private:
-  ofPoint jointToScreen( const JointType _jointType );
-  ofPoint bodyPointToScreen( const CameraSpacePoint& _bodyPoint );
+  const ofPoint& jointToScreen( const JointType _jointType ) const { return joint_points[ _jointType ]; }
 
-  Device*         device;
-  vector<Joint>   joints;
-  vector<ofPoint> joint_points;
+  Joint           joints[ JointType_Count ];
+  ofPoint         joint_points[ JointType_Count ];
+  ofPoint         joint_depth_points[ JointType_Count ];
+  PointF          lean;
   bool            is_tracked;
   UINT64          id;
   TrackingState   lean_state;
@@ -386,12 +929,122 @@ private:
 };
 
 
+// BodyFrame
+//   immutable snapshot published once per body frame, holds no heap memory.
+//   keep the Ref as long as needed, the reader thread never touches it again.
+//--------------------------------------------------------------------------------
+struct ofxKinect2::BodyFrame
+{
+  typedef std::shared_ptr< const BodyFrame > Ref;
+
+  BodyFrame()
+    : timestamp( 0 )
+  {
+    std::fill( index_slots, index_slots + index_size, -1 );
+  }
+
+  // tracking id -> slot, -1 when the id isn't tracked in this frame
+  int findSlot( UINT64 _id ) const
+  {
+    for( int h = hash( _id ); index_slots[ h ] >= 0; h = ( h + 1 ) & ( index_size - 1 ) )
+    {
+      if( index_ids[ h ] == _id ) return index_slots[ h ];
+    }
+    return -1;
+  }
+
+  const Body* findBody( UINT64 _id ) const
+  {
+    int slot = findSlot( _id );
+    return slot < 0 ? nullptr : &bodies[ slot ];
+  }
+
+  // called by the reader thread once the bodies are updated
+  void buildIndex()
+  {
+    std::fill( index_slots, index_slots + index_size, -1 );
+    for( int i = 0; i < BODY_COUNT; ++i )
+    {
+      if( !bodies[ i ].isTracked() ) continue;
+
+      int h = hash( bodies[ i ].getId() );
+      while( index_slots[ h ] >= 0 ) h = ( h + 1 ) & ( index_size - 1 );
+
+      index_ids[ h ]   = bodies[ i ].getId();
+      index_slots[ h ] = i;
+    }
+  }
+
+  UINT64  timestamp;
+  ofVec4f floor_clip_plane;
+  Body    bodies[ BODY_COUNT ];
+
+private:
+  // open addressing, at most BODY_COUNT of index_size entries are used
+  static const int index_size = 16;
+  static int hash( UINT64 _id ){ return ( int )( ( _id * 0x9E3779B97F4A7C15ull ) >> 60 ); }
+
+  UINT64  index_ids[ index_size ];
+  int     index_slots[ index_size ];
+};
+
+
+// BodyEvent
+//   transition detected on the reader thread, notified on the main thread by Device::update()
+//--------------------------------------------------------------------------------
+struct ofxKinect2::BodyEvent
+{
+  BodyEventType type;
+  int           slot;
+  UINT64        id;
+  UINT64        timestamp;
+
+  // BODY_EVENT_HAND_LEFT / BODY_EVENT_HAND_RIGHT only
+  HandState     hand_state;
+  HandState     previous_hand_state;
+};
+
+
+// HandCrop
+//   square depth patch around a hand, ( depth - hand depth ) / half size in
+//   [ -1, 1 ], 1 where there is no depth. the patch covers a fixed metric size
+//   so its pixel radius shrinks as the hand moves away.
+//--------------------------------------------------------------------------------
+struct ofxKinect2::HandCrop
+{
+  HandCrop()
+    : is_valid( false )
+    , slot( 0 )
+    , id( 0 )
+    , is_left( false )
+    , state( HandState_Unknown )
+    , depth( 0 )
+    , radius( 0 )
+    , timestamp( 0 )
+  {
+  }
+
+  bool          is_valid;
+  int           slot;
+  UINT64        id;
+  bool          is_left;
+  HandState     state;
+  ofVec2f       center;  // depth space
+  float         depth;   // meters
+  float         radius;  // depth pixels
+  UINT64        timestamp;
+  ofFloatPixels pixels;
+};
+
+
 // BodyStream
 //--------------------------------------------------------------------------------
-class ofxKinect2::BodyStream : public Stream
+class ofxKinect2::BodyStream : public ofxKinect2::StreamT< ofxKinect2::BodyStream, ofxKinect2::BodyTraits >
 {
+  friend class ofxKinect2::StreamT< ofxKinect2::BodyStream, ofxKinect2::BodyTraits >;
+
 public:
-  BodyStream() : Stream()
+  BodyStream() : StreamT()
   {
   }
   
@@ -401,17 +1054,19 @@ public:
 
   bool setup( ofxKinect2::Device& _device )
   {
-    for( int i = 0; i < BODY_COUNT; ++i )
-    {
-      Body body;
-      body.setup( _device );
-      bodies.push_back( body );
-    }
+    snapshot            = std::make_shared< BodyFrame >();
+    p_mapper            = nullptr;
+    filter_timestamp    = 0;
+    is_gestures_enabled = false;
+    p_depth             = nullptr;
+    hand_crop_size      = 64;
+    hand_crop_meters    = 0.3f;
+    std::fill( event_ids, event_ids + BODY_COUNT, 0 );
+    std::fill( event_left_states, event_left_states + BODY_COUNT, HandState_Unknown );
+    std::fill( event_right_states, event_right_states + BODY_COUNT, HandState_Unknown );
+    std::fill( filter_ids, filter_ids + BODY_COUNT, 0 );
     return Stream::setup( _device, SENSOR_BODY );
   }
-  bool open();
-  void close();
-
   void update();
 
   void draw();
@@ -422,32 +1077,264 @@ public:
   void drawHandRight();
   void drawLean();
 
-  inline size_t        getNumBodies() { return bodies.size(); }
-  const vector< Body > getBodies() { return bodies; }
+  // enter / leave / hand state changes, notified on the main thread by Device::update()
+  ofEvent< BodyEvent >        body_event;
+  // gesture matches, notified on the main thread by Device::update()
+  ofEvent< GestureEventArgs > gesture_recognized;
+
+  // latest published frame, lock free
+  BodyFrame::Ref       getFrame() const { return std::atomic_load( &snapshot ); }
+
+  // joint smoothing, applied on the reader thread before projection
+  void                 setJointFilter( JointFilterType _type );
+  void                 setJointFilter( const DoubleExponentialParams& _params );
+  void                 setJointFilter( const OneEuroParams& _params );
+  JointFilterType      getJointFilterType() const { return joint_filter.getType(); }
+
+  // motion history of the last _num_frames per body, 0 disables it
+  void                 setHistorySize( int _num_frames );
+  // copies the latest _num_frames, all when 0, into _history and reuses its storage
+  void                 getHistory( JointHistory& _history, int _num_frames = 0 );
+
+  // template matching on the smoothed joints, runs on the reader thread. see GestureRecognizer
+  inline void          setGesturesEnabled( bool _enabled ){ is_gestures_enabled = _enabled; }
+  inline bool          isGesturesEnabled() const { return is_gestures_enabled; }
+  void                 setGestureJoints( const vector< JointType >& _joints );
+  void                 setGestureThreshold( float _threshold );
+  void                 setGestureBand( float _band );
+  void                 setGestureCooldown( int _frames );
+  void                 addGestureTemplate( const string& _name, const vector< float >& _frames );
+  void                 removeGestureTemplates( const string& _name );
+  size_t               getNumGestureTemplates();
+  string               getGestureTemplateName( size_t _i );
+  void                 startGestureRecording( UINT64 _id );
+  void                 stopGestureRecording( const string& _name );
+  bool                 isGestureRecording();
+  bool                 saveGestures( const string& _path );
+  bool                 loadGestures( const string& _path );
+
+  // hand crops need the depth stream, one crop per hand slot: 2 * BODY_COUNT, left first
+  void                 setDepth( DepthStream& _depth );
+  void                 setHandCropSize( int _pixels, float _meters = 0.3f );
+  const vector< HandCrop >& getHandCrops() const { return hand_crops.getFrontBuffer(); }
+
+  inline size_t        getNumBodies() const { return BODY_COUNT; }
+
+  // copies the latest frame, prefer getFrame()
+  const vector< Body > getBodies() const
+  {
+    BodyFrame::Ref f = getFrame();
+    return vector< Body >( f->bodies, f->bodies + BODY_COUNT );
+  }
 
-  const Body getBody( size_t _idx )
+  // body by tracking id, an untracked Body when the id is gone
+  const Body getBody( UINT64 _id ) const
   {
-    for( int i = 0; i < bodies.size(); ++i )
-    {
-      if( bodies[ i ].getId() == _idx )
-      {
-        return bodies[ _idx ];
-      }
-    }
-    return bodies[ 0 ];
+    BodyFrame::Ref f = getFrame();
+    const Body*    b = f->findBody( _id );
+    return b ? *b : Body();
   }
 
+  bool                 hasBody( UINT64 _id ) const { return getFrame()->findSlot( _id ) >= 0; }
+
   ofShortPixels&       getPixels(){ return pix.getFrontBuffer(); }
   const ofShortPixels& getPixels() const { return pix.getFrontBuffer(); }
   ofShortPixels&       getPixels( int _near, int _far, bool invert = false );
   const ofShortPixels& getPixels( int _near, int _far, bool invert = false ) const;
 
+  // ( nx, ny, nz, d ) of the floor in camera space, zero until the sensor finds it
+  ofVec4f              getFloorClipPlane() const { return getFrame()->floor_clip_plane; }
+
 protected:
-  bool readFrame();
-  void setPixels( Frame _frame );
+  void    setPixels( const Frame& _frame );
+  HRESULT openSource( IBodyFrameSource* _p_source );
+  void    closeSource();
+  HRESULT acquire( IBodyFrame* _p_frame );
+  void filterJoints();
+  void projectJoints();
+  void updateHistory();
+  void recognizeGestures();
+  void detectEvents();
+  void extractHandCrops();
+  void sampleHandCrop( HandCrop& _crop, const unsigned short* _depth, int _width, int _height );
+  void pushEvent( BodyEventType _type, int _slot, UINT64 _id, HandState _state = HandState_Unknown, HandState _previous = HandState_Unknown );
+  void publishSnapshot();
+  void notifyEvents();
 
   DoubleBuffer< ofShortPixels > pix;
-  vector< Body >                bodies;
+  BodyFrame                     body_frame;
+  BodyFrame::Ref                snapshot;
+  SnapshotPool< BodyFrame >     snapshot_pool;
+  ICoordinateMapper*            p_mapper;
+
+  JointFilter< BODY_COUNT * JointType_Count > joint_filter;
+  UINT64                                      filter_ids[ BODY_COUNT ];
+  UINT64                                      filter_timestamp;
+
+  JointHistory                                history;
+  GestureRecognizer                           gestures;
+  bool                                        is_gestures_enabled;
+  SpscQueue< GestureEventArgs >               gesture_events;
+
+  // last state seen per slot, 0 id when untracked
+  SpscQueue< BodyEvent >                      events;
+  UINT64                                      event_ids[ BODY_COUNT ];
+  HandState                                   event_left_states[ BODY_COUNT ];
+  HandState                                   event_right_states[ BODY_COUNT ];
+
+  DepthStream*                                p_depth;
+  DoubleBuffer< vector< HandCrop > >          hand_crops;
+  int                                         hand_crop_size;
+  float                                       hand_crop_meters;
+  float                                       hand_crop_radii[ BODY_COUNT ][ 2 ];
+
+  // per body: the joints, the lean vector and a point at the edge of each hand crop
+  static const int              num_projected_points = BODY_COUNT * ( JointType_Count + 3 );
+  CameraSpacePoint              camera_points[ num_projected_points ];
+  ColorSpacePoint               color_points[ num_projected_points ];
+  DepthSpacePoint               depth_points[ num_projected_points ];
+};
+
+
+// SkeletonRenderer
+//   all bones, joints, hands and leans of a BodyFrame in one vertex / color
+//   buffer: lines first, triangles after, drawn with two calls. build() only
+//   touches memory so it can run and be timed without a GL context.
+//--------------------------------------------------------------------------------
+class ofxKinect2::SkeletonRenderer
+{
+public:
+  static const int num_bones = 24;
+  static const int hand_segments = 8;
+
+  // per body: bones and lean as lines, joint quads and hand fans as triangles
+  static const int max_line_vertices     = BODY_COUNT * ( num_bones + 1 ) * 2;
+  static const int max_triangle_vertices = BODY_COUNT * ( JointType_Count * 6 + 2 * hand_segments * 3 );
+  static const int max_vertices          = max_line_vertices + max_triangle_vertices;
+
+  SkeletonRenderer()
+    : num_line_vertices( 0 )
+    , num_triangle_vertices( 0 )
+    , joint_size( 5 )
+    , hand_size( 30 )
+    , is_vbo_allocated( false )
+  {
+    for( int k = 0; k <= hand_segments; ++k )
+    {
+      float a     = TWO_PI * k / hand_segments;
+      circle[ k ] = ofVec3f( cos( a ), sin( a ) );
+    }
+  }
+
+  void setJointSize( float _size ){ joint_size = _size; }
+  void setHandSize( float _size ){ hand_size = _size; }
+
+  void build( const BodyFrame& _frame );
+  void update();
+  void draw();
+
+  // build() and draw() in one, from the stream's latest frame
+  void draw( const BodyStream& _stream );
+
+  const ofVec3f*      getVertices() const { return vertices; }
+  const ofFloatColor* getColors() const { return colors; }
+  int                 getNumLineVertices() const { return num_line_vertices; }
+  int                 getNumTriangleVertices() const { return num_triangle_vertices; }
+
+  static const JointType bones[ num_bones ][ 2 ];
+
+protected:
+  void addLine( const ofVec3f& _p0, const ofVec3f& _p1, const ofFloatColor& _color );
+  void addQuad( const ofVec3f& _center, float _size, const ofFloatColor& _color );
+  void addHand( const ofVec3f& _center, HandState _state );
+
+  ofVec3f      vertices[ max_vertices ];
+  ofFloatColor colors[ max_vertices ];
+  int          num_line_vertices;
+  int          num_triangle_vertices;
+  float        joint_size;
+  float        hand_size;
+  ofVec3f      circle[ hand_segments + 1 ];
+
+  ofVbo        vbo;
+  bool         is_vbo_allocated;
+};
+
+
+// AudioBeam
+//   beam direction of one audio sub frame, radians in the sensor's horizontal
+//   plane ( 0 is straight ahead ), confidence 0 to 1
+//--------------------------------------------------------------------------------
+struct ofxKinect2::AudioBeam
+{
+  float  angle;
+  float  confidence;
+  UINT64 timestamp;
+
+  // index of the sub frame's first sample in the whole stream
+  UINT64 sample_position;
+};
+
+
+// AudioStream
+//   beam formed microphone array audio, 16 kHz mono float. the reader thread
+//   drains every sub frame into a lock free ring that the audio callback pulls
+//   from, so the only latency is what the ring holds.
+//--------------------------------------------------------------------------------
+class ofxKinect2::AudioStream : public ofxKinect2::StreamT< ofxKinect2::AudioStream, ofxKinect2::AudioTraits >
+{
+  friend class ofxKinect2::StreamT< ofxKinect2::AudioStream, ofxKinect2::AudioTraits >;
+
+public:
+  static const int sample_rate = 16000;
+
+  AudioStream() : StreamT()
+  {
+  }
+
+  ~AudioStream()
+  {
+  }
+
+  // at least _buffer_ms of audio can queue up before new samples are dropped
+  bool setup( ofxKinect2::Device& _device, int _buffer_ms = 100 )
+  {
+    samples.allocate( max( _buffer_ms, 1 ) * sample_rate / 1000 );
+    beams.allocate( 64 );
+    sample_position = 0;
+    beam_angle.store( 0 );
+    beam_confidence.store( 0 );
+    return Stream::setup( _device, SENSOR_AUDIO );
+  }
+
+  void update();
+
+  // audio thread, no locks or allocation. fills _buffer_size frames of _n_channels
+  // interleaved channels with the mono beam, zeros on underrun. returns the frames read
+  int readSamples( float* _output, int _buffer_size, int _n_channels = 1 );
+
+  // any thread. beam of the latest sub frame
+  inline float getBeamAngle() const { return beam_angle.load(); }
+  inline float getBeamAngleConfidence() const { return beam_confidence.load(); }
+
+  // one consumer thread. beam of every sub frame in order, false when none is left
+  bool         popBeam( AudioBeam& _beam ) { return beams.pop( _beam ); }
+
+  // queued samples and samples dropped because the ring was full
+  inline int    getNumQueuedSamples() const { return ( int )samples.size(); }
+  inline float  getLatency() const { return ( float )samples.size() * 1000.f / sample_rate; }
+  inline size_t getNumDroppedSamples() const { return samples.getNumDropped(); }
+
+protected:
+  void    setPixels( const Frame& _frame );
+  HRESULT acquire( IAudioBeamFrameList* _p_frame_list );
+  HRESULT readSubFrame( IAudioBeamSubFrame* _p_sub_frame );
+
+  SpscQueue< float >     samples;
+  SpscQueue< AudioBeam > beams;
+  UINT64                 sample_position;
+  std::atomic< float >   beam_angle;
+  std::atomic< float >   beam_confidence;
 };
 
 
@@ -463,6 +1350,7 @@ public:
     , depth_values( nullptr )
     , depth_pixels( nullptr )
     , color_pixels( nullptr )
+    , p_depth_stream( nullptr )
   {
   }
 
@@ -519,9 +1407,24 @@ public:
   ofVec2f                mapCameraToColorSpace( CameraSpacePoint _camera_point );
   vector< ofVec2f >      mapCameraToColorSpace( vector< ofVec3f > _camera_points );
 
+  // per pixel ( x / z, y / z ) rays of the depth camera, cached once the SDK returns a calibrated table.
+  // empty until then, the sensor has to be running
+  const vector< ofVec2f >& getDepthFrameToCameraSpaceTable();
+  // uncached, false while the table is not calibrated. safe from the reader threads
+  bool                     queryDepthFrameToCameraSpaceTable( vector< ofVec2f >& _table ) const;
+
   // setter
   void setDepthFromShortPixels( const ofShortPixels* _depth_pixels ){ depth_pixels = _depth_pixels; }
-  void setDepth( ofxKinect2::DepthStream& _depth_stream ){ depth_pixels = &_depth_stream.getPixels(); }
+  void setDepth( ofxKinect2::DepthStream& _depth_stream )
+  {
+    if( p_depth_stream != &_depth_stream )
+    {
+      if( p_depth_stream ) p_depth_stream->releaseRawPixels();
+      _depth_stream.retainRawPixels();
+      p_depth_stream = &_depth_stream;
+    }
+    depth_pixels = &_depth_stream.getPixels();
+  }
   void setColorFromPixels( const ofPixels* _color_pixels ){ color_pixels = _color_pixels; }
   void setColor( ofxKinect2::ColorStream& _color_stream ){ color_pixels = &_color_stream.getPixels(); }
 
@@ -540,6 +1443,7 @@ private:
   ICoordinateMapper*     p_mapper;
   const ofShortPixels*   depth_pixels;
   const ofPixels*        color_pixels;
+  DepthStream*           p_depth_stream;
   ofPixels               coordinate_color_pixels;
 
   DepthSpacePoint*       depth_space_points;
@@ -550,6 +1454,7 @@ private:
   vector< ofVec3f >      depth_to_camera_points;
   vector< ofVec2f >      color_to_depth_points;
   vector< ofVec3f >      color_to_camera_points;
+  vector< ofVec2f >      depth_to_camera_table;
 
   vector< ofFloatColor > depth_to_float_colors;
   vector< ofColor >      depth_to_colors;
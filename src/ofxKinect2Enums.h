@@ -31,7 +31,11 @@ namespace ofxKinect2
     PIXEL_FORMAT_YUV,
     PIXEL_FORMAT_BGRA,
     PIXEL_FORMAT_BAYER,
-    PIXEL_FORMAT_YUY2
+    PIXEL_FORMAT_YUY2,
+    PIXEL_FORMAT_RGB,
+    PIXEL_FORMAT_GRAY,   // 8 bit
+    PIXEL_FORMAT_GRAY16, // 16 bit, raw sensor values
+    PIXEL_FORMAT_FLOAT   // depth in meters, ir in 0 - 1
   };
 
   enum DeviceState
@@ -40,4 +44,39 @@ namespace ofxKinect2
     DEVICE_STATE_ERROR,
     DEVICE_STATE_NOT_READY 
   };
+
+  enum JointFilterType
+  {
+    JOINT_FILTER_NONE,
+    JOINT_FILTER_DOUBLE_EXPONENTIAL,
+    JOINT_FILTER_ONE_EURO
+  };
+
+  enum DepthPyramidMode
+  {
+    DEPTH_PYRAMID_MIN,
+    DEPTH_PYRAMID_MEDIAN,
+    DEPTH_PYRAMID_MEAN
+  };
+
+  enum BodyEventType
+  {
+    BODY_EVENT_ENTER,
+    BODY_EVENT_LEAVE,
+    BODY_EVENT_HAND_LEFT,
+    BODY_EVENT_HAND_RIGHT
+  };
+
+  enum ScaleFilter
+  {
+    SCALE_FILTER_BOX,
+    SCALE_FILTER_BILINEAR
+  };
+
+  enum IrExposure
+  {
+    IR_EXPOSURE_FIXED,    // setRange()
+    IR_EXPOSURE_AUTO,     // range follows the histogram percentiles
+    IR_EXPOSURE_EQUALIZE  // auto range and histogram equalization
+  };
 }
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "ofxKinect2Types.h"
+
+namespace ofxKinect2
+{
+  // SensorTraits
+  //   compile time description of one sensor for StreamT: the SDK source, reader
+  //   and frame interfaces, and how a frame and its payload are acquired.
+  //------------------------------------------------------------------------------
+  template< class SourceType, class ReaderType, class FrameInterface >
+  struct SensorTraits
+  {
+    typedef SourceType     Source;
+    typedef ReaderType     Reader;
+    typedef FrameInterface FrameType;
+
+    static const bool is_zero_copy_supported = false;
+
+    static HRESULT acquireLatestFrame( Reader* _p_reader, FrameType** _pp_frame )
+    {
+      return _p_reader->AcquireLatestFrame( _pp_frame );
+    }
+
+    static HRESULT getTimestamp( FrameType* _p_frame, UINT64* _p_timestamp )
+    {
+      return _p_frame->get_RelativeTime( ( INT64* )_p_timestamp );
+    }
+
+    // sets *_pp_description to nullptr for sensors without images
+    static HRESULT getFrameDescription( Source* _p_source, IFrameDescription** _pp_description )
+    {
+      return _p_source->get_FrameDescription( _pp_description );
+    }
+
+    // frame arrived event, only zero copy streams wait on it
+    static HRESULT subscribeFrameArrived( Reader* _p_reader, WAITABLE_HANDLE* _p_event ) { return E_NOTIMPL; }
+    static void    unsubscribeFrameArrived( Reader* _p_reader, WAITABLE_HANDLE _event ) {}
+    static bool    isFrameArrived( Reader* _p_reader, WAITABLE_HANDLE _event ) { return true; }
+  };
+
+  // ZeroCopySensorTraits
+  //   16 bit sensors whose frames can be held by a FrameHandle. the reader hands out
+  //   a new frame only once the held one is released, so the stream waits for the
+  //   frame arrived event before it gives up the published frame.
+  //------------------------------------------------------------------------------
+  template< class SourceType, class ReaderType, class FrameInterface, class ArrivedEventArgs >
+  struct ZeroCopySensorTraits : SensorTraits< SourceType, ReaderType, FrameInterface >
+  {
+    typedef SensorTraits< SourceType, ReaderType, FrameInterface > Base;
+    typedef typename Base::Reader                                   Reader;
+    typedef typename Base::FrameType                                FrameType;
+    typedef unsigned short                                          Pixel;
+
+    static const bool is_zero_copy_supported = true;
+
+    static HRESULT access( FrameType* _p_frame, Frame& _frame )
+    {
+      return _p_frame->AccessUnderlyingBuffer( ( UINT* )&_frame.data_size, reinterpret_cast< UINT16** >( &_frame.data ) );
+    }
+
+    static HRESULT subscribeFrameArrived( Reader* _p_reader, WAITABLE_HANDLE* _p_event )
+    {
+      return _p_reader->SubscribeFrameArrived( _p_event );
+    }
+
+    static void unsubscribeFrameArrived( Reader* _p_reader, WAITABLE_HANDLE _event )
+    {
+      _p_reader->UnsubscribeFrameArrived( _event );
+    }
+
+    // polls without blocking, consumes the event data when signaled
+    static bool isFrameArrived( Reader* _p_reader, WAITABLE_HANDLE _event )
+    {
+      if( WaitForSingleObject( reinterpret_cast< HANDLE >( _event ), 0 ) != WAIT_OBJECT_0 ) return false;
+
+      ArrivedEventArgs* p_args = nullptr;
+      if( SUCCEEDED( _p_reader->GetFrameArrivedEventData( _event, &p_args ) ) ) p_args->Release();
+      return true;
+    }
+  };
+
+  struct ColorTraits : SensorTraits< IColorFrameSource, IColorFrameReader, IColorFrame >
+  {
+    static const char* getName() { return "ofxKinect2::ColorStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_color_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_ColorFrameSource( _pp_source ); }
+  };
+
+  struct DepthTraits : ZeroCopySensorTraits< IDepthFrameSource, IDepthFrameReader, IDepthFrame, IDepthFrameArrivedEventArgs >
+  {
+    static const char* getName() { return "ofxKinect2::DepthStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_depth_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_DepthFrameSource( _pp_source ); }
+  };
+
+  struct IrTraits : ZeroCopySensorTraits< IInfraredFrameSource, IInfraredFrameReader, IInfraredFrame, IInfraredFrameArrivedEventArgs >
+  {
+    static const char* getName() { return "ofxKinect2::IrStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_infrared_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_InfraredFrameSource( _pp_source ); }
+  };
+
+  struct LongExposureIrTraits : ZeroCopySensorTraits< ILongExposureInfraredFrameSource, ILongExposureInfraredFrameReader, ILongExposureInfraredFrame, ILongExposureInfraredFrameArrivedEventArgs >
+  {
+    static const char* getName() { return "ofxKinect2::LongExposureIrStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_long_exposure_infrared_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_LongExposureInfraredFrameSource( _pp_source ); }
+  };
+
+  struct BodyIndexTraits : SensorTraits< IBodyIndexFrameSource, IBodyIndexFrameReader, IBodyIndexFrame >
+  {
+    typedef unsigned char Pixel;
+
+    static const char* getName() { return "ofxKinect2::BodyIndexStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_body_index_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_BodyIndexFrameSource( _pp_source ); }
+
+    static HRESULT     access( FrameType* _p_frame, Frame& _frame )
+    {
+      return _p_frame->AccessUnderlyingBuffer( ( UINT* )&_frame.data_size, reinterpret_cast< BYTE** >( &_frame.data ) );
+    }
+  };
+
+  struct BodyTraits : SensorTraits< IBodyFrameSource, IBodyFrameReader, IBodyFrame >
+  {
+    static const char* getName() { return "ofxKinect2::BodyStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_body_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_BodyFrameSource( _pp_source ); }
+
+    static HRESULT     getFrameDescription( Source* _p_source, IFrameDescription** _pp_description )
+    {
+      *_pp_description = nullptr;
+      return S_OK;
+    }
+  };
+
+  // one beam frame list per read, the timestamp comes from its sub frames
+  struct AudioTraits : SensorTraits< IAudioSource, IAudioBeamFrameReader, IAudioBeamFrameList >
+  {
+    static const char* getName() { return "ofxKinect2::AudioStream"; }
+    static Reader*&    getReader( StreamHandle& _stream ) { return _stream.p_audio_beam_frame_reader; }
+    static HRESULT     getSource( IKinectSensor* _p_sensor, Source** _pp_source ) { return _p_sensor->get_AudioSource( _pp_source ); }
+
+    static HRESULT     acquireLatestFrame( Reader* _p_reader, FrameType** _pp_frame )
+    {
+      return _p_reader->AcquireLatestBeamFrames( _pp_frame );
+    }
+
+    static HRESULT     getTimestamp( FrameType*, UINT64* )
+    {
+      return S_OK;
+    }
+
+    static HRESULT     getFrameDescription( Source*, IFrameDescription** _pp_description )
+    {
+      *_pp_description = nullptr;
+      return S_OK;
+    }
+  };
+}
@@ -33,6 +33,20 @@ namespace ofxKinect2
     int         resolution_y;
   };
 
+  // static per stream metadata, read once at open()
+  struct FrameDescription
+  {
+    int          width;
+    int          height;
+
+    float        horizontal_field_of_view;
+    float        vertical_field_of_view;
+    float        diagonal_field_of_view;
+
+    unsigned int bytes_per_pixel;
+    unsigned int length_in_pixels;
+  };
+
   struct Frame
   {
     int        data_size;
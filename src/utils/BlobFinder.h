@@ -0,0 +1,169 @@
+#pragma once
+
+#include "ofMain.h"
+
+namespace ofxKinect2
+{
+  struct Blob
+  {
+    int     area;
+    float   weight;
+    ofVec2f centroid;
+    int     min_x, min_y, max_x, max_y;
+  };
+
+  class BlobFinder;
+}
+
+// BlobFinder
+//   single pass run-length connected components ( 8-connected ) on a binary mask
+//   with weighted sub-pixel centroids. runs and labels are kept between calls.
+//--------------------------------------------------------------------------------
+class ofxKinect2::BlobFinder
+{
+public:
+  BlobFinder()
+    : min_area( 1 )
+    , max_area( numeric_limits< int >::max() )
+  {
+  }
+
+  void setAreaRange( int _min_area, int _max_area ){ min_area = _min_area; max_area = _max_area; }
+
+  void find( const unsigned char* _mask, int _width, int _height )
+  {
+    find( _mask, _width, _height, []( int, int ){ return 1.f; } );
+  }
+
+  // _weight( x, y ) gives the centroid weight of a mask pixel
+  template< class WeightFunc >
+  void find( const unsigned char* _mask, int _width, int _height, WeightFunc _weight )
+  {
+    runs.clear();
+    parents.clear();
+    sums.clear();
+    blobs.clear();
+
+    size_t prev_begin = 0, prev_end = 0;
+    for( int y = 0; y < _height; ++y )
+    {
+      const unsigned char* row       = _mask + y * _width;
+      size_t               cur_begin = runs.size();
+      size_t               p         = prev_begin;
+
+      int x = 0;
+      while( x < _width )
+      {
+        if( !row[ x ] )
+        {
+          ++x;
+          continue;
+        }
+
+        Run run;
+        run.y      = y;
+        run.start  = x;
+        run.weight = run.wx = run.wy = 0;
+        for( ; x < _width && row[ x ]; ++x )
+        {
+          float w     = _weight( x, y );
+          run.weight += w;
+          run.wx     += w * x;
+          run.wy     += w * y;
+        }
+        run.end   = x - 1;
+        run.label = -1;
+
+        // previous row runs touching [ start - 1, end + 1 ]
+        while( p < prev_end && runs[ p ].end < run.start - 1 ) ++p;
+        for( size_t q = p; q < prev_end && runs[ q ].start <= run.end + 1; ++q )
+        {
+          if( run.label < 0 ) run.label = findRoot( runs[ q ].label );
+          else                unite( run.label, runs[ q ].label );
+        }
+        if( run.label < 0 )
+        {
+          run.label = parents.size();
+          parents.push_back( run.label );
+        }
+        runs.push_back( run );
+      }
+
+      prev_begin = cur_begin;
+      prev_end   = runs.size();
+    }
+
+    // accumulate runs into their roots
+    slots.assign( parents.size(), -1 );
+    for( auto& r : runs )
+    {
+      int root = findRoot( r.label );
+      if( slots[ root ] < 0 )
+      {
+        slots[ root ] = blobs.size();
+        Blob b;
+        b.area   = 0;
+        b.weight = 0;
+        b.min_x  = r.start; b.max_x = r.end;
+        b.min_y  = b.max_y = r.y;
+        blobs.push_back( b );
+        sums.resize( blobs.size() );
+        sums.back() = ofVec2f();
+      }
+      int   i = slots[ root ];
+      Blob& b = blobs[ i ];
+      b.area   += r.end - r.start + 1;
+      b.weight += r.weight;
+      b.min_x   = min( b.min_x, r.start );
+      b.max_x   = max( b.max_x, r.end );
+      b.max_y   = max( b.max_y, r.y );
+      sums[ i ] += ofVec2f( r.wx, r.wy );
+    }
+
+    size_t n = 0;
+    for( size_t i = 0; i < blobs.size(); ++i )
+    {
+      Blob& b = blobs[ i ];
+      if( b.area < min_area || b.area > max_area || b.weight <= 0 ) continue;
+
+      b.centroid   = sums[ i ] / b.weight;
+      blobs[ n++ ] = b;
+    }
+    blobs.resize( n );
+  }
+
+  const vector< Blob >& getBlobs() const { return blobs; }
+
+private:
+  struct Run
+  {
+    int   y, start, end;
+    int   label;
+    float weight, wx, wy;
+  };
+
+  int findRoot( int _label )
+  {
+    while( parents[ _label ] != _label )
+    {
+      parents[ _label ] = parents[ parents[ _label ] ];
+      _label            = parents[ _label ];
+    }
+    return _label;
+  }
+
+  void unite( int _a, int _b )
+  {
+    _a = findRoot( _a );
+    _b = findRoot( _b );
+    if( _a < _b )      parents[ _b ] = _a;
+    else if( _b < _a ) parents[ _a ] = _b;
+  }
+
+  int               min_area, max_area;
+  vector< Run >     runs;
+  vector< int >     parents;
+  vector< int >     slots;
+  vector< ofVec2f > sums;
+  vector< Blob >    blobs;
+};
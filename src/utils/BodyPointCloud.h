@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Kinect.h"
+#include "Parallel.h"
+
+namespace ofxKinect2
+{
+  class BodyPointCloud;
+}
+
+// BodyPointCloud
+//   splits depth into one camera space point cloud per body index. pixels are
+//   counted per row chunk, prefix summed into per body offsets and written in a
+//   second pass, so every body's points are one contiguous span of one buffer.
+//--------------------------------------------------------------------------------
+class ofxKinect2::BodyPointCloud
+{
+public:
+  BodyPointCloud()
+    : width( 0 )
+    , height( 0 )
+    , num_chunks( 0 )
+  {
+    std::fill( begins, begins + BODY_COUNT, 0 );
+    std::fill( counts, counts + BODY_COUNT, 0 );
+  }
+
+  // _table is Mapper::getDepthFrameToCameraSpaceTable()
+  void setup( const vector< ofVec2f >& _table, int _width, int _height )
+  {
+    table      = _table;
+    width      = _width;
+    height     = _height;
+    num_chunks = min( _height, max( 1, getNumWorkers() * 4 ) );
+
+    points.resize( _width * _height );
+    pixel_indices.resize( _width * _height );
+    chunk_counts.assign( num_chunks * BODY_COUNT, 0 );
+  }
+
+  // BodyIndexStream::getIndexPixels(), enabled or PIXEL_FORMAT_GRAY, and DepthStream::getPixels() of the same size
+  void update( const ofPixels& _index, const ofShortPixels& _depth )
+  {
+    if( _index.getWidth() != width || _index.getHeight() != height || _depth.getWidth() != width || _depth.getHeight() != height ) return;
+    update( _index.getData(), _depth.getData() );
+  }
+
+  void update( const unsigned char* _index, const unsigned short* _depth )
+  {
+    if( !_index || !_depth || ( int )table.size() != width * height ) return;
+
+    const int rows_per = ( height + num_chunks - 1 ) / num_chunks;
+
+    // pass 1: histogram per chunk
+    parallelFor( 0, num_chunks, [ & ]( int _c )
+    {
+      int local[ BODY_COUNT ] = { 0 };
+      int end                 = min( height, ( _c + 1 ) * rows_per ) * width;
+      for( int i = _c * rows_per * width; i < end; ++i )
+      {
+        unsigned char b = _index[ i ];
+        if( b < BODY_COUNT && _depth[ i ] ) ++local[ b ];
+      }
+      std::copy( local, local + BODY_COUNT, &chunk_counts[ _c * BODY_COUNT ] );
+    } );
+
+    // body major prefix sum, chunk_counts becomes each chunk's write cursor
+    int offset = 0;
+    for( int b = 0; b < BODY_COUNT; ++b )
+    {
+      begins[ b ] = offset;
+      for( int c = 0; c < num_chunks; ++c )
+      {
+        int n                              = chunk_counts[ c * BODY_COUNT + b ];
+        chunk_counts[ c * BODY_COUNT + b ] = offset;
+        offset                            += n;
+      }
+      counts[ b ] = offset - begins[ b ];
+    }
+
+    // pass 2: scatter and map
+    parallelFor( 0, num_chunks, [ & ]( int _c )
+    {
+      int* cursor = &chunk_counts[ _c * BODY_COUNT ];
+      int  end    = min( height, ( _c + 1 ) * rows_per ) * width;
+      for( int i = _c * rows_per * width; i < end; ++i )
+      {
+        unsigned char b = _index[ i ];
+        if( b >= BODY_COUNT || !_depth[ i ] ) continue;
+
+        float z            = _depth[ i ] * 0.001f;
+        int   o            = cursor[ b ]++;
+        points[ o ].set( table[ i ].x * z, table[ i ].y * z, z );
+        pixel_indices[ o ] = i;
+      }
+    } );
+  }
+
+  // span of _body's points, valid until the next update()
+  const ofVec3f* getPoints( int _body ) const { return points.data() + begins[ _body ]; }
+  int            getNumPoints( int _body ) const { return counts[ _body ]; }
+
+  // depth pixel index of each point, parallel to getPoints()
+  const int*     getPixelIndices( int _body ) const { return pixel_indices.data() + begins[ _body ]; }
+
+  // all bodies back to back, body 0 first
+  const vector< ofVec3f >& getPoints() const { return points; }
+  int            getTotalNumPoints() const { return begins[ BODY_COUNT - 1 ] + counts[ BODY_COUNT - 1 ]; }
+
+private:
+  vector< ofVec2f > table;
+  int               width, height;
+  int               num_chunks;
+
+  vector< ofVec3f > points;
+  vector< int >     pixel_indices;
+  vector< int >     chunk_counts;
+  int               begins[ BODY_COUNT ];
+  int               counts[ BODY_COUNT ];
+};
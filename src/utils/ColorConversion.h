@@ -0,0 +1,191 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+#include "Parallel.h"
+#include "PixelConversion.h"
+
+// YUY2 ( Y0 U Y1 V ) kernels, BT.601 video range in 6 bit fixed point:
+//   l = 74.5 * ( y - 16 ) + 32
+//   r = ( l + 102 * v ) >> 6
+//   g = ( l - 25 * u - 52 * v ) >> 6
+//   b = ( l + 129 * u ) >> 6      with u, v centered on 128
+namespace ofxKinect2
+{
+  inline unsigned char clampToByte( int _v )
+  {
+    return ( unsigned char )( _v < 0 ? 0 : ( _v > 255 ? 255 : _v ) );
+  }
+
+  inline void yuvToRgb( int _y, int _u, int _v, unsigned char& _r, unsigned char& _g, unsigned char& _b )
+  {
+    int y = 74 * ( _y - 16 ) + ( ( _y - 16 ) >> 1 ) + 32;
+    int u = _u - 128;
+    int v = _v - 128;
+    _r    = clampToByte( ( y + 102 * v ) >> 6 );
+    _g    = clampToByte( ( y - 25 * u - 52 * v ) >> 6 );
+    _b    = clampToByte( ( y + 129 * u ) >> 6 );
+  }
+
+  // one row of _width pixels to 4 channels, _swap_rb writes BGRA instead of RGBA
+  inline void convertYuy2RowToRgba( const unsigned char* _src, unsigned char* _dst, int _width, bool _swap_rb )
+  {
+    int x = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i low    = _mm_set1_epi16( 0x00FF );
+    const __m128i even   = _mm_set1_epi32( 0x0000FFFF );
+    const __m128i y_off  = _mm_set1_epi16( 16 );
+    const __m128i round  = _mm_set1_epi16( 32 );
+    const __m128i uv_off = _mm_set1_epi16( 128 );
+    const __m128i c_y    = _mm_set1_epi16( 74 );
+    const __m128i c_rv   = _mm_set1_epi16( 102 );
+    const __m128i c_gu   = _mm_set1_epi16( 25 );
+    const __m128i c_gv   = _mm_set1_epi16( 52 );
+    const __m128i c_bu   = _mm_set1_epi16( 129 );
+    const __m128i alpha  = _mm_set1_epi8( ( char )0xFF );
+    const __m128i zero   = _mm_setzero_si128();
+    for( ; x + 8 <= _width; x += 8 )
+    {
+      __m128i s  = _mm_loadu_si128( ( const __m128i* )( _src + x * 2 ) );
+      __m128i l  = _mm_sub_epi16( _mm_and_si128( s, low ), y_off );
+      __m128i y  = _mm_add_epi16( _mm_add_epi16( _mm_mullo_epi16( l, c_y ), _mm_srai_epi16( l, 1 ) ), round );
+      __m128i uv = _mm_sub_epi16( _mm_srli_epi16( s, 8 ), uv_off );
+
+      // U0 V0 U1 V1 .. -> U0 U0 U1 U1 .. and V0 V0 V1 V1 ..
+      __m128i u = _mm_and_si128( uv, even );
+      u         = _mm_or_si128( u, _mm_slli_epi32( u, 16 ) );
+      __m128i v = _mm_srai_epi32( uv, 16 );
+      v         = _mm_or_si128( _mm_and_si128( v, even ), _mm_slli_epi32( v, 16 ) );
+
+      // saturation only happens where the result clamps to 0 or 255 anyway
+      __m128i r = _mm_srai_epi16( _mm_adds_epi16( y, _mm_mullo_epi16( v, c_rv ) ), 6 );
+      __m128i g = _mm_srai_epi16( _mm_subs_epi16( _mm_subs_epi16( y, _mm_mullo_epi16( u, c_gu ) ), _mm_mullo_epi16( v, c_gv ) ), 6 );
+      __m128i b = _mm_srai_epi16( _mm_adds_epi16( y, _mm_mullo_epi16( u, c_bu ) ), 6 );
+      if( _swap_rb ) std::swap( r, b );
+
+      __m128i rg = _mm_unpacklo_epi8( _mm_packus_epi16( r, zero ), _mm_packus_epi16( g, zero ) );
+      __m128i ba = _mm_unpacklo_epi8( _mm_packus_epi16( b, zero ), alpha );
+      _mm_storeu_si128( ( __m128i* )( _dst + x * 4 ),      _mm_unpacklo_epi16( rg, ba ) );
+      _mm_storeu_si128( ( __m128i* )( _dst + x * 4 + 16 ), _mm_unpackhi_epi16( rg, ba ) );
+    }
+#endif
+
+    const int r = _swap_rb ? 2 : 0;
+    const int b = _swap_rb ? 0 : 2;
+    for( ; x + 2 <= _width; x += 2 )
+    {
+      const unsigned char* s = _src + x * 2;
+      unsigned char*       d = _dst + x * 4;
+      yuvToRgb( s[ 0 ], s[ 1 ], s[ 3 ], d[ r ], d[ 1 ], d[ b ] );
+      yuvToRgb( s[ 2 ], s[ 1 ], s[ 3 ], d[ 4 + r ], d[ 5 ], d[ 4 + b ] );
+      d[ 3 ] = d[ 7 ] = 255;
+    }
+  }
+
+  // the Y plane of one row
+  inline void extractYuy2RowLuma( const unsigned char* _src, unsigned char* _dst, int _width )
+  {
+    int x = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i low = _mm_set1_epi16( 0x00FF );
+    for( ; x + 16 <= _width; x += 16 )
+    {
+      __m128i a = _mm_and_si128( _mm_loadu_si128( ( const __m128i* )( _src + x * 2 ) ),      low );
+      __m128i b = _mm_and_si128( _mm_loadu_si128( ( const __m128i* )( _src + x * 2 + 16 ) ), low );
+      _mm_storeu_si128( ( __m128i* )( _dst + x ), _mm_packus_epi16( a, b ) );
+    }
+#endif
+
+    for( ; x < _width; ++x ) _dst[ x ] = _src[ x * 2 ];
+  }
+
+  // whole frames, rows split across the workers
+  inline void convertYuy2ToRgba( const unsigned char* _src, unsigned char* _dst, int _width, int _height, bool _swap_rb = false )
+  {
+    parallelFor( 0, _height, [ & ]( int _y )
+    {
+      convertYuy2RowToRgba( _src + _y * _width * 2, _dst + _y * _width * 4, _width, _swap_rb );
+    } );
+  }
+
+  inline void extractYuy2Luma( const unsigned char* _src, unsigned char* _dst, int _width, int _height )
+  {
+    parallelFor( 0, _height, [ & ]( int _y )
+    {
+      extractYuy2RowLuma( _src + _y * _width * 2, _dst + _y * _width, _width );
+    } );
+  }
+
+  inline void convertYuy2RowToRgb( const unsigned char* _src, unsigned char* _dst, int _width )
+  {
+    for( int x = 0; x + 2 <= _width; x += 2 )
+    {
+      const unsigned char* s = _src + x * 2;
+      unsigned char*       d = _dst + x * 3;
+      yuvToRgb( s[ 0 ], s[ 1 ], s[ 3 ], d[ 0 ], d[ 1 ], d[ 2 ] );
+      yuvToRgb( s[ 2 ], s[ 1 ], s[ 3 ], d[ 3 ], d[ 4 ], d[ 5 ] );
+    }
+  }
+
+  // any 8 bit format, averaging _k x _k blocks in YUV before converting
+  inline void convertYuy2( const unsigned char* _src, unsigned char* _dst, PixelFormat _format, int _width, int _height, int _k = 1 )
+  {
+    const int ow       = _width / _k;
+    const int oh       = _height / _k;
+    const int channels = getNumChannels( _format );
+
+    if( _k == 1 )
+    {
+      switch( _format )
+      {
+      case PIXEL_FORMAT_RGBA: convertYuy2ToRgba( _src, _dst, _width, _height, false ); return;
+      case PIXEL_FORMAT_BGRA: convertYuy2ToRgba( _src, _dst, _width, _height, true );  return;
+      case PIXEL_FORMAT_GRAY: extractYuy2Luma( _src, _dst, _width, _height );          return;
+      case PIXEL_FORMAT_YUY2: memcpy( _dst, _src, _width * _height * 2 );              return;
+      default: break;
+      }
+    }
+
+    parallelFor( 0, oh, [ & ]( int _oy )
+    {
+      if( _k == 1 && _format == PIXEL_FORMAT_RGB )
+      {
+        convertYuy2RowToRgb( _src + _oy * _width * 2, _dst + _oy * _width * 3, _width );
+        return;
+      }
+
+      const int      n = _k * _k;
+      unsigned char* d = _dst + _oy * ow * channels;
+      for( int ox = 0; ox < ow; ++ox, d += channels )
+      {
+        int sum_y = 0, sum_u = 0, sum_v = 0;
+        for( int y = 0; y < _k; ++y )
+        {
+          const unsigned char* row = _src + ( _oy * _k + y ) * _width * 2;
+          for( int x = ox * _k; x < ox * _k + _k; ++x )
+          {
+            const unsigned char* pair = row + ( x & ~1 ) * 2;
+            sum_y += row[ x * 2 ];
+            sum_u += pair[ 1 ];
+            sum_v += pair[ 3 ];
+          }
+        }
+
+        if( _format == PIXEL_FORMAT_GRAY )
+        {
+          d[ 0 ] = sum_y / n;
+          continue;
+        }
+
+        unsigned char r, g, b;
+        yuvToRgb( sum_y / n, sum_u / n, sum_v / n, r, g, b );
+        d[ 0 ] = _format == PIXEL_FORMAT_BGRA ? b : r;
+        d[ 1 ] = g;
+        d[ 2 ] = _format == PIXEL_FORMAT_BGRA ? r : b;
+        if( channels == 4 ) d[ 3 ] = 255;
+      }
+    } );
+  }
+}
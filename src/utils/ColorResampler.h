@@ -0,0 +1,189 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Parallel.h"
+#include "ColorConversion.h"
+#include "../ofxKinect2Enums.h"
+
+namespace ofxKinect2
+{
+  class ColorResampler;
+}
+
+// ColorResampler
+//   crops and scales a color frame to any size while converting it. source
+//   footprints ( box ) or taps and weights ( bilinear ) are precomputed per
+//   column and row, bands of output rows are spread over the workers.
+//--------------------------------------------------------------------------------
+class ofxKinect2::ColorResampler
+{
+public:
+  ColorResampler()
+    : src_width( 0 )
+    , src_height( 0 )
+    , dst_width( 0 )
+    , dst_height( 0 )
+    , filter( SCALE_FILTER_BOX )
+  {
+  }
+
+  // _crop is clamped to the source, an empty one is the whole frame. the output is _scale times the crop
+  void setup( int _src_width, int _src_height, const ofRectangle& _crop, float _scale, ScaleFilter _filter )
+  {
+    src_width  = _src_width;
+    src_height = _src_height;
+    filter     = _filter;
+
+    ofRectangle r  = _crop.width > 0 && _crop.height > 0 ? _crop : ofRectangle( 0, 0, _src_width, _src_height );
+    float       x0 = ofClamp( r.x, 0, _src_width - 1 );
+    float       y0 = ofClamp( r.y, 0, _src_height - 1 );
+    crop.set( x0, y0, ofClamp( r.width, 1, _src_width - x0 ), ofClamp( r.height, 1, _src_height - y0 ) );
+
+    dst_width  = max( ( int )( crop.width * _scale + 0.5f ), 1 );
+    dst_height = max( ( int )( crop.height * _scale + 0.5f ), 1 );
+
+    buildTaps( crop.x, crop.width, src_width, dst_width, cols );
+    buildTaps( crop.y, crop.height, src_height, dst_height, rows );
+  }
+
+  bool isSetup( int _src_width, int _src_height ) const { return src_width == _src_width && src_height == _src_height; }
+
+  int                getWidth() const { return dst_width; }
+  int                getHeight() const { return dst_height; }
+  const ofRectangle& getCrop() const { return crop; }
+
+  // YUY2 source, interpolated in YUV. _format is RGBA, BGRA, RGB or GRAY ( luma )
+  void resampleYuy2( const unsigned char* _src, unsigned char* _dst, PixelFormat _format ) const
+  {
+    const int channels = getNumChannels( _format );
+    const int stride   = src_width * 2;
+
+    run( [ & ]( int _oy )
+    {
+      const Tap&     ty = rows[ _oy ];
+      unsigned char* d  = _dst + _oy * dst_width * channels;
+      for( int ox = 0; ox < dst_width; ++ox, d += channels )
+      {
+        const Tap& tx = cols[ ox ];
+        int        yuv[ 3 ];
+        for( int c = 0; c < 3; ++c )
+        {
+          // Y at x * 2, U and V at the pair's + 1 and + 3
+          yuv[ c ] = sample( ty, tx, [ & ]( int _x, int _y )
+          {
+            const unsigned char* row = _src + _y * stride;
+            return c == 0 ? row[ _x * 2 ] : row[ ( _x & ~1 ) * 2 + c * 2 - 1 ];
+          } );
+        }
+
+        if( _format == PIXEL_FORMAT_GRAY )
+        {
+          d[ 0 ] = yuv[ 0 ];
+          continue;
+        }
+        unsigned char r, g, b;
+        yuvToRgb( yuv[ 0 ], yuv[ 1 ], yuv[ 2 ], r, g, b );
+        write( d, _format, r, g, b, 255 );
+      }
+    } );
+  }
+
+  // 4 channel source
+  void resampleRgba( const unsigned char* _src, bool _src_bgra, unsigned char* _dst, PixelFormat _format ) const
+  {
+    const int channels = getNumChannels( _format );
+    const int stride   = src_width * 4;
+
+    run( [ & ]( int _oy )
+    {
+      const Tap&     ty = rows[ _oy ];
+      unsigned char* d  = _dst + _oy * dst_width * channels;
+      for( int ox = 0; ox < dst_width; ++ox, d += channels )
+      {
+        const Tap& tx = cols[ ox ];
+        int        v[ 4 ];
+        for( int c = 0; c < 4; ++c )
+        {
+          v[ c ] = sample( ty, tx, [ & ]( int _x, int _y ){ return _src[ _y * stride + _x * 4 + c ]; } );
+        }
+        if( _src_bgra ) std::swap( v[ 0 ], v[ 2 ] );
+
+        if( _format == PIXEL_FORMAT_GRAY ) d[ 0 ] = ( 77 * v[ 0 ] + 150 * v[ 1 ] + 29 * v[ 2 ] ) >> 8;
+        else                               write( d, _format, v[ 0 ], v[ 1 ], v[ 2 ], v[ 3 ] );
+      }
+    } );
+  }
+
+private:
+  // box: [ i0, i1 ) footprint. bilinear: i0 and i0 + 1 weighted by 256 - w, w
+  struct Tap
+  {
+    int i0, i1, w;
+  };
+
+  void buildTaps( float _offset, float _length, int _src_size, int _dst_size, vector< Tap >& _taps ) const
+  {
+    const float step = _length / _dst_size;
+    _taps.resize( _dst_size );
+    for( int i = 0; i < _dst_size; ++i )
+    {
+      Tap& t = _taps[ i ];
+      if( filter == SCALE_FILTER_BOX )
+      {
+        t.i0 = min( ( int )( _offset + i * step ), _src_size - 1 );
+        t.i1 = min( max( ( int )( _offset + ( i + 1 ) * step ), t.i0 + 1 ), _src_size );
+        t.w  = 0;
+      }
+      else
+      {
+        float s = ofClamp( _offset + ( i + 0.5f ) * step - 0.5f, 0, _src_size - 1 );
+        t.i0    = min( ( int )s, _src_size - 2 );
+        t.i1    = t.i0 + 1;
+        t.w     = ( int )( ( s - t.i0 ) * 256 + 0.5f );
+      }
+    }
+  }
+
+  template< class Fetch >
+  int sample( const Tap& _ty, const Tap& _tx, Fetch _fetch ) const
+  {
+    if( filter == SCALE_FILTER_BILINEAR )
+    {
+      int top    = _fetch( _tx.i0, _ty.i0 ) * ( 256 - _tx.w ) + _fetch( _tx.i1, _ty.i0 ) * _tx.w;
+      int bottom = _fetch( _tx.i0, _ty.i1 ) * ( 256 - _tx.w ) + _fetch( _tx.i1, _ty.i1 ) * _tx.w;
+      return ( top * ( 256 - _ty.w ) + bottom * _ty.w + ( 1 << 15 ) ) >> 16;
+    }
+
+    int sum = 0;
+    for( int y = _ty.i0; y < _ty.i1; ++y )
+    {
+      for( int x = _tx.i0; x < _tx.i1; ++x ) sum += _fetch( x, y );
+    }
+    return sum / ( ( _ty.i1 - _ty.i0 ) * ( _tx.i1 - _tx.i0 ) );
+  }
+
+  static void write( unsigned char* _d, PixelFormat _format, int _r, int _g, int _b, int _a )
+  {
+    _d[ 0 ] = _format == PIXEL_FORMAT_BGRA ? _b : _r;
+    _d[ 1 ] = _g;
+    _d[ 2 ] = _format == PIXEL_FORMAT_BGRA ? _r : _b;
+    if( _format == PIXEL_FORMAT_RGBA || _format == PIXEL_FORMAT_BGRA ) _d[ 3 ] = _a;
+  }
+
+  // bands of 16 output rows per task
+  template< class RowFunc >
+  void run( RowFunc _row ) const
+  {
+    const int band = 16;
+    parallelFor( 0, ( dst_height + band - 1 ) / band, [ & ]( int _b )
+    {
+      for( int y = _b * band; y < min( dst_height, ( _b + 1 ) * band ); ++y ) _row( y );
+    } );
+  }
+
+  int           src_width, src_height;
+  int           dst_width, dst_height;
+  ofRectangle   crop;
+  ScaleFilter   filter;
+  vector< Tap > cols, rows;
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+
+namespace ofxKinect2
+{
+  // interleaved vertex: camera space position in meters + depth pixel texcoord
+  struct DepthMeshVertex
+  {
+    float x, y, z;
+    float u, v;
+  };
+
+  class DepthMesh;
+}
+
+// DepthMesh
+//   organized triangle mesh over the depth grid.
+//   topology is built once in setup(), update() only rewrites positions
+//   and compacts the triangles that don't span a depth discontinuity.
+//--------------------------------------------------------------------------------
+class ofxKinect2::DepthMesh
+{
+public:
+  DepthMesh()
+    : width( 0 )
+    , height( 0 )
+    , step( 1 )
+    , cols( 0 )
+    , rows( 0 )
+    , num_indices( 0 )
+    , max_edge( 50 )
+  {
+  }
+
+  // _table is Mapper::getDepthFrameToCameraSpaceTable(), _step decimates the grid.
+  // fails while the table isn't available yet ( empty before the mapper has calibration )
+  bool setup( int _width, int _height, const vector< ofVec2f >& _table, int _step = 1 )
+  {
+    if( ( int )_table.size() != _width * _height )
+    {
+      ofLogWarning( "ofxKinect2::DepthMesh" ) << "Depth frame to camera space table doesn't match " << _width << "x" << _height << ".";
+      return false;
+    }
+
+    width  = _width;
+    height = _height;
+    step   = max( _step, 1 );
+    cols   = ( width  - 1 ) / step + 1;
+    rows   = ( height - 1 ) / step + 1;
+
+    table.resize( cols * rows );
+    vertices.resize( cols * rows );
+    vertex_depth.assign( cols * rows + 8, 0 );
+
+    for( int r = 0; r < rows; ++r )
+    {
+      for( int c = 0; c < cols; ++c )
+      {
+        int              i = r * cols + c;
+        DepthMeshVertex& v = vertices[ i ];
+        v.x = v.y = v.z = 0;
+        v.u = c * step;
+        v.v = r * step;
+        table[ i ] = _table[ r * step * width + c * step ];
+      }
+    }
+
+    // two triangles per grid cell, ( 00, 10, 01 ) and ( 01, 10, 11 )
+    grid_indices.resize( ( cols - 1 ) * ( rows - 1 ) * 6 );
+    ofIndexType* idx = grid_indices.data();
+    for( int r = 0; r < rows - 1; ++r )
+    {
+      for( int c = 0; c < cols - 1; ++c )
+      {
+        ofIndexType i00 = r * cols + c;
+        ofIndexType i01 = i00 + 1;
+        ofIndexType i10 = i00 + cols;
+        ofIndexType i11 = i10 + 1;
+        *idx++ = i00; *idx++ = i10; *idx++ = i01;
+        *idx++ = i01; *idx++ = i10; *idx++ = i11;
+      }
+    }
+    indices.resize( grid_indices.size() );
+    num_indices = 0;
+    return true;
+  }
+
+  // max depth difference ( mm ) along a triangle edge before it gets culled
+  void setMaxEdgeLength( unsigned short _max_edge ){ max_edge = _max_edge; }
+
+  void update( const ofShortPixels& _depth ){ if( _depth.getWidth() == width ) update( _depth.getData() ); }
+
+  void update( const unsigned short* _depth )
+  {
+    if( !_depth || vertices.empty() ) return;
+
+    // positions
+    for( int r = 0; r < rows; ++r )
+    {
+      const unsigned short* src = _depth + r * step * width;
+      int                   i   = r * cols;
+      for( int c = 0; c < cols; ++c, ++i )
+      {
+        unsigned short   d = src[ c * step ];
+        float            z = d * 0.001f;
+        DepthMeshVertex& v = vertices[ i ];
+        v.x = table[ i ].x * z;
+        v.y = table[ i ].y * z;
+        v.z = z;
+        vertex_depth[ i ] = d;
+      }
+    }
+
+    // cull
+    ofIndexType* dst = indices.data();
+    for( int r = 0; r < rows - 1; ++r )
+    {
+      const unsigned short* d0  = &vertex_depth[ r * cols ];
+      const unsigned short* d1  = d0 + cols;
+      const ofIndexType*    src = &grid_indices[ r * ( cols - 1 ) * 6 ];
+      int                   c   = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i edge = _mm_set1_epi16( ( short )max_edge );
+      for( ; c + 8 <= cols - 1; c += 8 )
+      {
+        __m128i a = _mm_loadu_si128( ( const __m128i* )( d0 + c ) );
+        __m128i b = _mm_loadu_si128( ( const __m128i* )( d0 + c + 1 ) );
+        __m128i e = _mm_loadu_si128( ( const __m128i* )( d1 + c ) );
+        __m128i f = _mm_loadu_si128( ( const __m128i* )( d1 + c + 1 ) );
+
+        __m128i invalid_be = _mm_or_si128( _mm_cmpeq_epi16( b, zero ), _mm_cmpeq_epi16( e, zero ) );
+        __m128i long_be    = exceeds( b, e, edge );
+        __m128i bad0       = _mm_or_si128( _mm_or_si128( invalid_be, long_be ), _mm_or_si128( _mm_cmpeq_epi16( a, zero ), _mm_or_si128( exceeds( a, b, edge ), exceeds( a, e, edge ) ) ) );
+        __m128i bad1       = _mm_or_si128( _mm_or_si128( invalid_be, long_be ), _mm_or_si128( _mm_cmpeq_epi16( f, zero ), _mm_or_si128( exceeds( b, f, edge ), exceeds( e, f, edge ) ) ) );
+
+        int mask0 = ~_mm_movemask_epi8( bad0 );
+        int mask1 = ~_mm_movemask_epi8( bad1 );
+        if( ( ( mask0 | mask1 ) & 0xFFFF ) == 0 ) continue;
+
+        for( int k = 0; k < 8; ++k )
+        {
+          const ofIndexType* tri = src + ( c + k ) * 6;
+          if( mask0 & ( 1 << ( k * 2 ) ) ) { dst[ 0 ] = tri[ 0 ]; dst[ 1 ] = tri[ 1 ]; dst[ 2 ] = tri[ 2 ]; dst += 3; }
+          if( mask1 & ( 1 << ( k * 2 ) ) ) { dst[ 0 ] = tri[ 3 ]; dst[ 1 ] = tri[ 4 ]; dst[ 2 ] = tri[ 5 ]; dst += 3; }
+        }
+      }
+#endif
+
+      for( ; c < cols - 1; ++c )
+      {
+        unsigned short a = d0[ c ], b = d0[ c + 1 ], e = d1[ c ], f = d1[ c + 1 ];
+        const ofIndexType* tri = src + c * 6;
+
+        bool be = b && e && absdiff( b, e ) <= max_edge;
+        if( be && a && absdiff( a, b ) <= max_edge && absdiff( a, e ) <= max_edge )
+        {
+          dst[ 0 ] = tri[ 0 ]; dst[ 1 ] = tri[ 1 ]; dst[ 2 ] = tri[ 2 ]; dst += 3;
+        }
+        if( be && f && absdiff( b, f ) <= max_edge && absdiff( e, f ) <= max_edge )
+        {
+          dst[ 0 ] = tri[ 3 ]; dst[ 1 ] = tri[ 4 ]; dst[ 2 ] = tri[ 5 ]; dst += 3;
+        }
+      }
+    }
+    num_indices = dst - indices.data();
+  }
+
+  // getter
+  const DepthMeshVertex* getVertexData() const { return vertices.data(); }
+  size_t                 getNumVertices() const { return vertices.size(); }
+  int                    getVertexStride() const { return sizeof( DepthMeshVertex ); }
+
+  const ofIndexType*     getIndexData() const { return indices.data(); }
+  size_t                 getNumIndices() const { return num_indices; }
+  size_t                 getMaxNumIndices() const { return grid_indices.size(); }
+
+  int                    getCols() const { return cols; }
+  int                    getRows() const { return rows; }
+
+private:
+  static int absdiff( unsigned short _a, unsigned short _b ){ return _a > _b ? _a - _b : _b - _a; }
+
+#ifdef OFXKINECT2_USE_SSE2
+  static __m128i exceeds( __m128i _a, __m128i _b, __m128i _edge )
+  {
+    __m128i diff = _mm_or_si128( _mm_subs_epu16( _a, _b ), _mm_subs_epu16( _b, _a ) );
+    return _mm_xor_si128( _mm_cmpeq_epi16( _mm_subs_epu16( diff, _edge ), _mm_setzero_si128() ), _mm_set1_epi16( -1 ) );
+  }
+#endif
+
+  int                       width, height, step;
+  int                       cols, rows;
+  size_t                    num_indices;
+  unsigned short            max_edge;
+
+  vector< ofVec2f >         table;
+  vector< DepthMeshVertex > vertices;
+  vector< unsigned short >  vertex_depth;
+  vector< ofIndexType >     grid_indices;
+  vector< ofIndexType >     indices;
+};
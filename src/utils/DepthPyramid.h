@@ -0,0 +1,182 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+#include "../ofxKinect2Enums.h"
+
+namespace ofxKinect2
+{
+  class DepthPyramid;
+}
+
+// DepthPyramid
+//   2x2 downsampling chain that ignores invalid ( zero ) depth.
+//   level 0 is half resolution, the full resolution frame is not copied.
+//--------------------------------------------------------------------------------
+class ofxKinect2::DepthPyramid
+{
+public:
+  DepthPyramid()
+    : mode( DEPTH_PYRAMID_MIN )
+  {
+  }
+
+  void setup( int _num_levels, DepthPyramidMode _mode )
+  {
+    mode = _mode;
+    levels.resize( max( _num_levels, 0 ) );
+  }
+
+  void build( const unsigned short* _src, int _width, int _height )
+  {
+    const unsigned short* src = _src;
+    int                   w   = _width;
+    int                   h   = _height;
+
+    for( auto& level : levels )
+    {
+      int dw = w / 2;
+      int dh = h / 2;
+      if( dw == 0 || dh == 0 ) break;
+
+      if( level.getWidth() != dw || level.getHeight() != dh ) level.allocate( dw, dh, 1 );
+
+      unsigned short* dst = level.getData();
+      for( int y = 0; y < dh; ++y )
+      {
+        const unsigned short* r0 = src + ( y * 2 ) * w;
+        const unsigned short* r1 = r0 + w;
+        unsigned short*       d  = dst + y * dw;
+
+        switch( mode )
+        {
+        case DEPTH_PYRAMID_MIN:    downsampleMin( r0, r1, d, dw );    break;
+        case DEPTH_PYRAMID_MEDIAN: downsampleMedian( r0, r1, d, dw ); break;
+        case DEPTH_PYRAMID_MEAN:   downsampleMean( r0, r1, d, dw );   break;
+        }
+      }
+
+      src = dst;
+      w   = dw;
+      h   = dh;
+    }
+  }
+
+  // getter
+  int                  getNumLevels() const { return levels.size(); }
+  DepthPyramidMode     getMode() const { return mode; }
+  const ofShortPixels& getLevel( int _level ) const { return levels[ _level ]; }
+
+private:
+  // zero is mapped to the largest value so that min() skips it
+  static void downsampleMin( const unsigned short* _r0, const unsigned short* _r1, unsigned short* _dst, int _dw )
+  {
+    int x = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i one  = _mm_set1_epi16( 1 );
+    const __m128i bias = _mm_set1_epi16( ( short )0x8000 );
+    for( ; x + 8 <= _dw; x += 8 )
+    {
+      __m128i a0 = _mm_xor_si128( _mm_sub_epi16( _mm_loadu_si128( ( const __m128i* )( _r0 + x * 2 ) ),     one ), bias );
+      __m128i a1 = _mm_xor_si128( _mm_sub_epi16( _mm_loadu_si128( ( const __m128i* )( _r0 + x * 2 + 8 ) ), one ), bias );
+      __m128i b0 = _mm_xor_si128( _mm_sub_epi16( _mm_loadu_si128( ( const __m128i* )( _r1 + x * 2 ) ),     one ), bias );
+      __m128i b1 = _mm_xor_si128( _mm_sub_epi16( _mm_loadu_si128( ( const __m128i* )( _r1 + x * 2 + 8 ) ), one ), bias );
+
+      __m128i m0   = _mm_min_epi16( a0, b0 );
+      __m128i m1   = _mm_min_epi16( a1, b1 );
+      __m128i even = _mm_packs_epi32( _mm_srai_epi32( _mm_slli_epi32( m0, 16 ), 16 ), _mm_srai_epi32( _mm_slli_epi32( m1, 16 ), 16 ) );
+      __m128i odd  = _mm_packs_epi32( _mm_srai_epi32( m0, 16 ), _mm_srai_epi32( m1, 16 ) );
+      __m128i m    = _mm_add_epi16( _mm_xor_si128( _mm_min_epi16( even, odd ), bias ), one );
+
+      _mm_storeu_si128( ( __m128i* )( _dst + x ), m );
+    }
+#endif
+
+    for( ; x < _dw; ++x )
+    {
+      unsigned short v[ 4 ] = { _r0[ x * 2 ], _r0[ x * 2 + 1 ], _r1[ x * 2 ], _r1[ x * 2 + 1 ] };
+      unsigned short m      = 0;
+      for( auto d : v )
+      {
+        if( d && ( !m || d < m ) ) m = d;
+      }
+      _dst[ x ] = m;
+    }
+  }
+
+  static void downsampleMean( const unsigned short* _r0, const unsigned short* _r1, unsigned short* _dst, int _dw )
+  {
+    int x = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i one   = _mm_set1_epi16( 1 );
+    const __m128i low   = _mm_set1_epi32( 0xFFFF );
+    const __m128i bias  = _mm_set1_epi32( 0x8000 );
+    const __m128  fone  = _mm_set1_ps( 1.f );
+    const __m128  fhalf = _mm_set1_ps( 0.5f );
+    for( ; x + 8 <= _dw; x += 8 )
+    {
+      __m128i out[ 2 ];
+      for( int k = 0; k < 2; ++k )
+      {
+        __m128i a = _mm_loadu_si128( ( const __m128i* )( _r0 + x * 2 + k * 8 ) );
+        __m128i b = _mm_loadu_si128( ( const __m128i* )( _r1 + x * 2 + k * 8 ) );
+
+        // each 32 bit lane holds one 2x1 pair
+        __m128i sum = _mm_add_epi32( _mm_add_epi32( _mm_and_si128( a, low ), _mm_srli_epi32( a, 16 ) ),
+                                     _mm_add_epi32( _mm_and_si128( b, low ), _mm_srli_epi32( b, 16 ) ) );
+
+        __m128i va  = _mm_add_epi16( _mm_cmpeq_epi16( a, zero ), one );
+        __m128i vb  = _mm_add_epi16( _mm_cmpeq_epi16( b, zero ), one );
+        __m128i cnt = _mm_add_epi16( va, vb );
+        cnt         = _mm_add_epi32( _mm_and_si128( cnt, low ), _mm_srli_epi32( cnt, 16 ) );
+
+        __m128 mean = _mm_div_ps( _mm_cvtepi32_ps( sum ), _mm_max_ps( _mm_cvtepi32_ps( cnt ), fone ) );
+        out[ k ]    = _mm_sub_epi32( _mm_cvttps_epi32( _mm_add_ps( mean, fhalf ) ), bias );
+      }
+      __m128i m = _mm_xor_si128( _mm_packs_epi32( out[ 0 ], out[ 1 ] ), _mm_set1_epi16( ( short )0x8000 ) );
+      _mm_storeu_si128( ( __m128i* )( _dst + x ), m );
+    }
+#endif
+
+    for( ; x < _dw; ++x )
+    {
+      unsigned short v[ 4 ] = { _r0[ x * 2 ], _r0[ x * 2 + 1 ], _r1[ x * 2 ], _r1[ x * 2 + 1 ] };
+      unsigned int   sum    = 0;
+      unsigned int   cnt    = 0;
+      for( auto d : v )
+      {
+        sum += d;
+        cnt += d != 0;
+      }
+      _dst[ x ] = cnt ? ( unsigned short )( ( float )sum / cnt + 0.5f ) : 0;
+    }
+  }
+
+  // lower median of the valid samples, always one of the measured values
+  static void downsampleMedian( const unsigned short* _r0, const unsigned short* _r1, unsigned short* _dst, int _dw )
+  {
+    for( int x = 0; x < _dw; ++x )
+    {
+      unsigned short v[ 4 ];
+      int            n = 0;
+      if( _r0[ x * 2 ] )     v[ n++ ] = _r0[ x * 2 ];
+      if( _r0[ x * 2 + 1 ] ) v[ n++ ] = _r0[ x * 2 + 1 ];
+      if( _r1[ x * 2 ] )     v[ n++ ] = _r1[ x * 2 ];
+      if( _r1[ x * 2 + 1 ] ) v[ n++ ] = _r1[ x * 2 + 1 ];
+
+      if( n == 0 )
+      {
+        _dst[ x ] = 0;
+        continue;
+      }
+      std::sort( v, v + n );
+      _dst[ x ] = v[ ( n - 1 ) / 2 ];
+    }
+  }
+
+  DepthPyramidMode        mode;
+  vector< ofShortPixels > levels;
+};
@@ -4,18 +4,23 @@
 
 namespace ofxKinect2
 {
-  inline void depthRemapToRange( const ofShortPixels &_src, ofShortPixels &_dst, int _near, int _far, int _invert )
+  inline void depthRemapToRange( const unsigned short* _src, int _width, int _height, ofShortPixels &_dst, int _near, int _far, int _invert )
   {
-    _dst.allocate( _src.getWidth(), _src.getHeight(), 1 );
+    _dst.allocate( _width, _height, 1 );
     
     unsigned short* dst_ptr = _dst.getPixels();
     
     if( _invert ) std::swap( _near, _far );
     
-    for( auto& p : _src )
+    for( int i = 0; i < _width * _height; ++i )
     {
-      *dst_ptr = ofMap( p, _near, _far, 0, 65535, true );
+      *dst_ptr = ofMap( _src[ i ], _near, _far, 0, 65535, true );
       ++dst_ptr;
     }
   }
+
+  inline void depthRemapToRange( const ofShortPixels &_src, ofShortPixels &_dst, int _near, int _far, int _invert )
+  {
+    depthRemapToRange( _src.getData(), _src.getWidth(), _src.getHeight(), _dst, _near, _far, _invert );
+  }
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Kinect.h"
+#include <atomic>
+#include <mutex>
+
+namespace ofxKinect2
+{
+  class FrameHandle;
+  class FramePool;
+}
+
+// FrameHandle
+//   read only 16 bit frame shared between the reader thread and consumers.
+//   it holds the SDK frame until the next one arrives, the reader thread then moves
+//   the frame into a pooled copy if consumers still hold the handle. read the data
+//   between lock() and unlock() from other threads, the pointer changes with that move.
+//--------------------------------------------------------------------------------
+class ofxKinect2::FrameHandle
+{
+  friend class ofxKinect2::FramePool;
+
+public:
+  typedef std::shared_ptr< const FrameHandle > Ref;
+
+  // keep it short and don't lock the stream meanwhile, the stream's reader thread waits for it
+  void                  lock() const { mutex.lock(); }
+  void                  unlock() const { mutex.unlock(); }
+
+  const unsigned short* getData() const { return data; }
+  int                   getWidth() const { return width; }
+  int                   getHeight() const { return height; }
+  UINT64                getTimestamp() const { return timestamp; }
+
+  // true while the SDK frame is held, false for a pooled copy
+  bool                  isZeroCopy() const { return p_frame != nullptr; }
+
+private:
+  FrameHandle()
+    : data( nullptr )
+    , width( 0 )
+    , height( 0 )
+    , timestamp( 0 )
+    , p_frame( nullptr )
+  {
+  }
+
+  const unsigned short*    data;
+  int                      width, height;
+  UINT64                   timestamp;
+  IUnknown*                p_frame;
+  vector< unsigned short > buffer;
+  mutable std::mutex       mutex;
+};
+
+// FramePool
+//   hands out FrameHandles. at most one SDK frame is held, the published one, so
+//   the sensor is never starved by consumers. up to max pooled handles and their
+//   copy buffers are recycled, no allocation once the pool is warm.
+//--------------------------------------------------------------------------------
+class ofxKinect2::FramePool : public std::enable_shared_from_this< ofxKinect2::FramePool >
+{
+public:
+  static std::shared_ptr< FramePool > create( int _max_pooled )
+  {
+    return std::shared_ptr< FramePool >( new FramePool( _max_pooled ) );
+  }
+
+  ~FramePool()
+  {
+    for( auto h : free_handles ) delete h;
+  }
+
+  void setMaxPooled( int _max_pooled ){ max_pooled = max( _max_pooled, 1 ); }
+  int  getMaxPooled() const { return max_pooled; }
+
+  // takes over _p_frame, _data must point into it
+  FrameHandle::Ref wrap( IUnknown* _p_frame, const unsigned short* _data, int _width, int _height, UINT64 _timestamp )
+  {
+    FrameHandle* h = nullptr;
+    {
+      std::lock_guard< std::mutex > guard( mutex );
+      if( !free_handles.empty() )
+      {
+        h = free_handles.back();
+        free_handles.pop_back();
+      }
+    }
+    if( !h ) h = new FrameHandle();
+
+    h->width     = _width;
+    h->height    = _height;
+    h->timestamp = _timestamp;
+    h->p_frame   = _p_frame;
+    h->data      = _data;
+
+    std::shared_ptr< FramePool > self = shared_from_this();
+    return FrameHandle::Ref( h, [ self ]( const FrameHandle* _h ){ self->recycle( const_cast< FrameHandle* >( _h ) ); } );
+  }
+
+  // reader thread, before the next SDK frame is acquired. copies the frame into the
+  // handle's buffer and gives the SDK frame back, consumers keep a valid handle
+  void detach( const FrameHandle::Ref& _handle )
+  {
+    FrameHandle* h = const_cast< FrameHandle* >( _handle.get() );
+    if( !h || !h->p_frame ) return;
+
+    std::lock_guard< std::mutex > guard( h->mutex );
+    h->buffer.assign( h->data, h->data + h->width * h->height );
+    h->data = h->buffer.data();
+    h->p_frame->Release();
+    h->p_frame = nullptr;
+  }
+
+private:
+  FramePool( int _max_pooled )
+    : max_pooled( max( _max_pooled, 1 ) )
+  {
+  }
+
+  // any thread, whoever drops the last Ref
+  void recycle( FrameHandle* _h )
+  {
+    if( _h->p_frame )
+    {
+      _h->p_frame->Release();
+      _h->p_frame = nullptr;
+    }
+    _h->data = nullptr;
+
+    std::lock_guard< std::mutex > guard( mutex );
+    if( ( int )free_handles.size() < max_pooled ) free_handles.push_back( _h );
+    else                                          delete _h;
+  }
+
+  std::mutex             mutex;
+  vector< FrameHandle* > free_handles;
+  int                    max_pooled;
+};
@@ -0,0 +1,402 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Kinect.h"
+#include "Parallel.h"
+#include <mutex>
+
+namespace ofxKinect2
+{
+  struct GestureEventArgs
+  {
+    string name;
+    UINT64 id;        // tracking id
+    float  distance;  // mean per frame DTW distance
+    UINT64 timestamp;
+  };
+
+  class GestureRecognizer;
+}
+
+// GestureRecognizer
+//   matches normalized joint trajectories against recorded templates with a
+//   banded, early abandoning DTW after an LB_Keogh prefilter. templates are
+//   evaluated in parallel, matches are returned to the caller on the reader thread.
+//--------------------------------------------------------------------------------
+class ofxKinect2::GestureRecognizer
+{
+public:
+  // load() rejects files beyond these
+  static const int max_templates       = 1024;
+  static const int max_name_length     = 256;
+  static const int max_template_length = 30 * 60;
+
+  GestureRecognizer()
+    : threshold( 0.15f )
+    , band( 0.1f )
+    , cooldown( 15 )
+    , max_length( 0 )
+    , recording_id( 0 )
+    , is_recording( false )
+  {
+    JointType joints[] = { JointType_HandLeft, JointType_HandRight, JointType_ElbowLeft, JointType_ElbowRight, JointType_WristLeft, JointType_WristRight };
+    setJoints( vector< JointType >( joints, joints + 6 ) );
+  }
+
+  // joints making up the feature vector, clears the templates
+  void setJoints( const vector< JointType >& _joints )
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    feature_joints = _joints;
+    dims           = ( int )feature_joints.size() * 3;
+    templates.clear();
+    max_length     = 0;
+    resetWindows();
+  }
+
+  // mean per frame distance to accept a match, in shoulder widths
+  void setThreshold( float _threshold ){ threshold = _threshold; }
+  // Sakoe-Chiba band as a fraction of the template length
+  void setBand( float _band ){ band = _band; }
+  // frames to ignore a body after it matched
+  void setCooldown( int _frames ){ cooldown = _frames; }
+
+  size_t getNumTemplates() const
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    return templates.size();
+  }
+
+  string getTemplateName( size_t _i ) const
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    return _i < templates.size() ? templates[ _i ].name : string();
+  }
+
+  void addTemplate( const string& _name, const vector< float >& _frames )
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    if( dims == 0 || _frames.size() < ( size_t )dims * 2 ) return;
+
+    Template t;
+    t.name   = _name;
+    t.length = ( int )( _frames.size() / dims );
+    t.frames.assign( _frames.begin(), _frames.begin() + t.length * dims );
+    buildEnvelope( t );
+    templates.push_back( t );
+    max_length = max( max_length, t.length );
+    resetWindows();
+  }
+
+  void removeTemplates( const string& _name )
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    ofRemove( templates, [ & ]( const Template& _t ){ return _t.name == _name; } );
+    max_length = 0;
+    for( auto& t : templates ) max_length = max( max_length, t.length );
+    resetWindows();
+  }
+
+  // recording, call stopRecording() to turn the captured frames into a template.
+  // frames beyond max_template_length are not recorded
+  void startRecording( UINT64 _id )
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    recording.clear();
+    recording_id = _id;
+    is_recording = true;
+  }
+
+  void stopRecording( const string& _name )
+  {
+    vector< float > frames;
+    {
+      std::lock_guard< std::mutex > guard( mutex );
+      is_recording = false;
+      frames.swap( recording );
+    }
+    addTemplate( _name, frames );
+  }
+
+  bool isRecording() const { return is_recording; }
+
+  // file: "KGST", version, dims, joints, then per template name, length, frames
+  bool save( const string& _path ) const
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    std::ofstream                 f( ofToDataPath( _path ).c_str(), std::ios::binary );
+    if( !f ) return false;
+
+    f.write( "KGST", 4 );
+    writeValue( f, ( int )1 );
+    writeValue( f, ( int )feature_joints.size() );
+    for( auto j : feature_joints ) writeValue( f, ( int )j );
+    writeValue( f, ( int )templates.size() );
+    for( auto& t : templates )
+    {
+      writeValue( f, ( int )t.name.size() );
+      f.write( t.name.data(), t.name.size() );
+      writeValue( f, t.length );
+      f.write( ( const char* )t.frames.data(), t.frames.size() * sizeof( float ) );
+    }
+    return f.good();
+  }
+
+  // the whole file is checked before anything is replaced
+  bool load( const string& _path )
+  {
+    std::ifstream f( ofToDataPath( _path ).c_str(), std::ios::binary );
+    char          magic[ 4 ];
+    int           version = 0, num_joints = 0, num_templates = 0;
+    bool          is_valid = f.read( magic, 4 ) && memcmp( magic, "KGST", 4 ) == 0 && readValue( f, version ) && version == 1 &&
+                             readValue( f, num_joints ) && num_joints >= 1 && num_joints <= JointType_Count;
+
+    vector< JointType > joints( is_valid ? num_joints : 0 );
+    for( auto& j : joints )
+    {
+      int v    = -1;
+      is_valid = is_valid && readValue( f, v ) && v >= 0 && v < JointType_Count;
+      j        = ( JointType )v;
+    }
+    is_valid = is_valid && readValue( f, num_templates ) && num_templates >= 0 && num_templates <= max_templates;
+
+    const int                                 file_dims = num_joints * 3;
+    vector< pair< string, vector< float > > > loaded;
+    for( int i = 0; i < num_templates && is_valid; ++i )
+    {
+      int length = 0, name_length = 0;
+      is_valid = readValue( f, name_length ) && name_length >= 0 && name_length <= max_name_length;
+      if( !is_valid ) break;
+
+      string name( name_length, ' ' );
+      is_valid = f.read( &name[ 0 ], name.size() ) && readValue( f, length ) && length >= 2 && length <= max_template_length;
+      if( !is_valid ) break;
+
+      vector< float > frames( ( size_t )length * file_dims );
+      is_valid = ( bool )f.read( ( char* )frames.data(), frames.size() * sizeof( float ) );
+      loaded.push_back( make_pair( name, frames ) );
+    }
+
+    if( !is_valid )
+    {
+      ofLogWarning( "ofxKinect2::GestureRecognizer" ) << "Can't load " << _path;
+      return false;
+    }
+
+    setJoints( joints );
+    for( auto& t : loaded ) addTemplate( t.first, t.second );
+    return true;
+  }
+
+  // reader thread, once per body slot and frame. true and _args filled on a match
+  bool update( int _slot, UINT64 _id, bool _tracked, const Joint* _joints, UINT64 _timestamp, GestureEventArgs& _args )
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    return process( _slot, _id, _tracked, _joints, _timestamp, _args );
+  }
+
+private:
+  bool process( int _slot, UINT64 _id, bool _tracked, const Joint* _joints, UINT64 _timestamp, GestureEventArgs& _args )
+  {
+    Window& w = windows[ _slot ];
+    if( !_tracked || w.id != _id )
+    {
+      w.count    = 0;
+      w.cooldown = 0;
+      w.id       = _id;
+    }
+    if( !_tracked ) return false;
+
+    // normalize: origin at the spine shoulder, scaled by the shoulder width
+    const CameraSpacePoint& o  = _joints[ JointType_SpineShoulder ].Position;
+    const CameraSpacePoint& sl = _joints[ JointType_ShoulderLeft ].Position;
+    const CameraSpacePoint& sr = _joints[ JointType_ShoulderRight ].Position;
+    float                   s  = ofVec3f( sl.X - sr.X, sl.Y - sr.Y, sl.Z - sr.Z ).length();
+    float                   k  = s > 0.05f ? 1.f / s : 0;
+
+    feature.resize( dims );
+    for( size_t i = 0; i < feature_joints.size(); ++i )
+    {
+      const CameraSpacePoint& p = _joints[ feature_joints[ i ] ].Position;
+      feature[ i * 3 + 0 ]      = ( p.X - o.X ) * k;
+      feature[ i * 3 + 1 ]      = ( p.Y - o.Y ) * k;
+      feature[ i * 3 + 2 ]      = ( p.Z - o.Z ) * k;
+    }
+
+    if( is_recording && _id == recording_id && recording.size() < ( size_t )max_template_length * dims )
+    {
+      recording.insert( recording.end(), feature.begin(), feature.end() );
+    }
+    if( max_length == 0 ) return false;
+
+    // window as a ring, query is its linearized tail
+    w.head = ( w.head + 1 ) % max_length;
+    std::copy( feature.begin(), feature.end(), w.frames.begin() + w.head * dims );
+    w.count = min( w.count + 1, max_length );
+
+    if( w.cooldown > 0 )
+    {
+      --w.cooldown;
+      return false;
+    }
+
+    for( int i = 0; i < w.count; ++i )
+    {
+      int src = ( w.head - w.count + 1 + i + max_length ) % max_length;
+      std::copy( w.frames.begin() + src * dims, w.frames.begin() + ( src + 1 ) * dims, query.begin() + i * dims );
+    }
+
+    const int count = w.count;
+    parallelFor( 0, ( int )templates.size(), [ & ]( int _t )
+    {
+      Template& t = templates[ _t ];
+      t.result    = count < t.length ? numeric_limits< float >::max() : match( t, query.data() + ( count - t.length ) * dims );
+    } );
+
+    int best = -1;
+    for( size_t i = 0; i < templates.size(); ++i )
+    {
+      if( templates[ i ].result < threshold && ( best < 0 || templates[ i ].result < templates[ best ].result ) ) best = ( int )i;
+    }
+    if( best < 0 ) return false;
+
+    _args.name      = templates[ best ].name;
+    _args.id        = _id;
+    _args.distance  = templates[ best ].result;
+    _args.timestamp = _timestamp;
+    w.count         = 0;
+    w.cooldown      = cooldown;
+    return true;
+  }
+
+  struct Template
+  {
+    string          name;
+    int             length;
+    vector< float > frames;
+    vector< float > upper, lower;
+    vector< float > rows;
+    float           result;
+  };
+
+  struct Window
+  {
+    Window() : id( 0 ), head( 0 ), count( 0 ), cooldown( 0 ) {}
+
+    UINT64          id;
+    vector< float > frames;
+    int             head, count, cooldown;
+  };
+
+  int bandWidth( int _length ) const { return max( 1, ( int )( _length * band ) ); }
+
+  // per dimension min / max of the template within the band
+  void buildEnvelope( Template& _t ) const
+  {
+    int r = bandWidth( _t.length );
+    _t.upper.assign( _t.frames.size(), -numeric_limits< float >::max() );
+    _t.lower.assign( _t.frames.size(), numeric_limits< float >::max() );
+    for( int i = 0; i < _t.length; ++i )
+    {
+      for( int j = max( 0, i - r ); j <= min( _t.length - 1, i + r ); ++j )
+      {
+        for( int d = 0; d < dims; ++d )
+        {
+          _t.upper[ i * dims + d ] = max( _t.upper[ i * dims + d ], _t.frames[ j * dims + d ] );
+          _t.lower[ i * dims + d ] = min( _t.lower[ i * dims + d ], _t.frames[ j * dims + d ] );
+        }
+      }
+    }
+    _t.rows.resize( ( _t.length + 1 ) * 2 );
+  }
+
+  float distance( const float* _a, const float* _b ) const
+  {
+    float sum = 0;
+    for( int d = 0; d < dims; ++d )
+    {
+      float v = _a[ d ] - _b[ d ];
+      sum    += v * v;
+    }
+    return sqrt( sum );
+  }
+
+  // mean per frame distance, max() when abandoned
+  float match( Template& _t, const float* _query ) const
+  {
+    const int   n     = _t.length;
+    const float limit = threshold * n;
+
+    // LB_Keogh
+    float lb = 0;
+    for( int i = 0; i < n && lb <= limit; ++i )
+    {
+      float sum = 0;
+      for( int d = 0; d < dims; ++d )
+      {
+        float q = _query[ i * dims + d ];
+        float u = _t.upper[ i * dims + d ];
+        float l = _t.lower[ i * dims + d ];
+        float e = q > u ? q - u : ( q < l ? l - q : 0 );
+        sum    += e * e;
+      }
+      lb += sqrt( sum );
+    }
+    if( lb > limit ) return numeric_limits< float >::max();
+
+    // banded DTW, two rows
+    const int   r    = bandWidth( n );
+    const float inf  = numeric_limits< float >::max();
+    float*      prev = _t.rows.data();
+    float*      cur  = prev + n + 1;
+
+    std::fill( prev, prev + n + 1, inf );
+    prev[ 0 ] = 0;
+    for( int i = 1; i <= n; ++i )
+    {
+      std::fill( cur, cur + n + 1, inf );
+      float row_min = inf;
+      for( int j = max( 1, i - r ); j <= min( n, i + r ); ++j )
+      {
+        float best = min( prev[ j - 1 ], min( prev[ j ], cur[ j - 1 ] ) );
+        if( best == inf ) continue;
+
+        cur[ j ] = best + distance( _query + ( i - 1 ) * dims, _t.frames.data() + ( j - 1 ) * dims );
+        row_min  = min( row_min, cur[ j ] );
+      }
+      if( row_min > limit ) return inf;
+      std::swap( prev, cur );
+    }
+    return prev[ n ] / n;
+  }
+
+  void resetWindows()
+  {
+    for( auto& w : windows )
+    {
+      w.frames.assign( max_length * dims, 0 );
+      w.count = w.head = w.cooldown = 0;
+    }
+    query.assign( max_length * dims, 0 );
+  }
+
+  template< class T >
+  static void writeValue( std::ofstream& _f, const T& _v ){ _f.write( ( const char* )&_v, sizeof( T ) ); }
+  template< class T >
+  static bool readValue( std::ifstream& _f, T& _v ){ return ( bool )_f.read( ( char* )&_v, sizeof( T ) ); }
+
+  mutable std::mutex  mutex;
+  vector< JointType > feature_joints;
+  int                 dims;
+  float               threshold, band;
+  int                 cooldown;
+
+  vector< Template >  templates;
+  int                 max_length;
+  Window              windows[ BODY_COUNT ];
+  vector< float >     feature, query;
+
+  vector< float >     recording;
+  UINT64              recording_id;
+  bool                is_recording;
+};
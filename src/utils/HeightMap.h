@@ -0,0 +1,163 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Parallel.h"
+
+namespace ofxKinect2
+{
+  class HeightMap;
+}
+
+// HeightMap
+//   projects depth straight onto the floor plane into a top-down grid.
+//   columns run along the sensor's right ( camera -x ), rows away from the sensor,
+//   each cell keeps the highest point above the floor and the point count.
+//--------------------------------------------------------------------------------
+class ofxKinect2::HeightMap
+{
+public:
+  HeightMap()
+    : cell_size( 0.05f )
+    , cols( 0 )
+    , rows( 0 )
+    , min_height( 0.1f )
+    , max_height( 2.5f )
+    , min_count( 4 )
+    , has_plane( false )
+  {
+  }
+
+  // _area is the floor region in meters ( x: right, y: forward ), _table is Mapper::getDepthFrameToCameraSpaceTable()
+  void setup( const ofRectangle& _area, float _cell_size, const vector< ofVec2f >& _table )
+  {
+    area      = _area;
+    cell_size = _cell_size;
+    table     = _table;
+    cols      = max( 1, ( int )ceil( area.getWidth()  / cell_size ) );
+    rows      = max( 1, ( int )ceil( area.getHeight() / cell_size ) );
+
+    height_pixels.allocate( cols, rows, 1 );
+    count_pixels.allocate( cols, rows, 1 );
+    occupancy_pixels.allocate( cols, rows, 1 );
+
+    int workers = getNumWorkers();
+    worker_heights.assign( workers, vector< float >( cols * rows, 0 ) );
+    worker_counts.assign( workers, vector< unsigned int >( cols * rows, 0 ) );
+  }
+
+  // ( nx, ny, nz, d ) with the normal pointing up, as BodyStream::getFloorClipPlane() or PlaneEstimator
+  void setFloorPlane( const ofVec4f& _plane )
+  {
+    ofVec3f n( _plane.x, _plane.y, _plane.z );
+    float   len = n.length();
+    has_plane   = len > 0;
+    if( !has_plane ) return;
+
+    normal  = n / len;
+    offset  = _plane.w / len;
+    // camera space +x is the sensor's left
+    right   = ( ofVec3f( -1, 0, 0 ) + normal * normal.x ).getNormalized();
+    forward = normal.getCrossed( right );
+  }
+
+  void setHeightRange( float _min_height, float _max_height ){ min_height = _min_height; max_height = _max_height; }
+  void setMinCount( int _min_count ){ min_count = _min_count; }
+
+  void update( const ofShortPixels& _depth ){ update( _depth.getData(), _depth.getWidth(), _depth.getHeight() ); }
+
+  void update( const unsigned short* _depth, int _width, int _height )
+  {
+    if( !has_plane || !_depth || ( int )table.size() != _width * _height || worker_heights.empty() ) return;
+
+    const int   workers  = worker_heights.size();
+    const int   rows_per = ( _height + workers - 1 ) / workers;
+    const float inv_cell = 1.f / cell_size;
+
+    // scatter, one private grid per worker
+    parallelFor( 0, workers, [ & ]( int _w )
+    {
+      float*        heights = worker_heights[ _w ].data();
+      unsigned int* counts  = worker_counts[ _w ].data();
+      std::fill( heights, heights + cols * rows, 0.f );
+      std::fill( counts, counts + cols * rows, 0 );
+
+      int y_end = min( _height, ( _w + 1 ) * rows_per );
+      for( int y = _w * rows_per; y < y_end; ++y )
+      {
+        const unsigned short* d = _depth + y * _width;
+        const ofVec2f*        t = table.data() + y * _width;
+        for( int x = 0; x < _width; ++x )
+        {
+          if( d[ x ] == 0 ) continue;
+
+          float   z = d[ x ] * 0.001f;
+          ofVec3f p( t[ x ].x * z, t[ x ].y * z, z );
+
+          float h = normal.dot( p ) + offset;
+          if( h < min_height || h > max_height ) continue;
+
+          int c = ( int )( ( right.dot( p )   - area.x ) * inv_cell );
+          int r = ( int )( ( forward.dot( p ) - area.y ) * inv_cell );
+          if( c < 0 || r < 0 || c >= cols || r >= rows ) continue;
+
+          int i = r * cols + c;
+          if( h > heights[ i ] ) heights[ i ] = h;
+          ++counts[ i ];
+        }
+      }
+    } );
+
+    // reduce
+    float*          height_dst    = height_pixels.getData();
+    unsigned short* count_dst     = count_pixels.getData();
+    unsigned char*  occupancy_dst = occupancy_pixels.getData();
+    parallelFor( 0, rows, [ & ]( int _r )
+    {
+      for( int i = _r * cols; i < ( _r + 1 ) * cols; ++i )
+      {
+        float        h = 0;
+        unsigned int n = 0;
+        for( int w = 0; w < workers; ++w )
+        {
+          h  = max( h, worker_heights[ w ][ i ] );
+          n += worker_counts[ w ][ i ];
+        }
+        height_dst[ i ]    = h;
+        count_dst[ i ]     = ( unsigned short )min( n, 65535u );
+        occupancy_dst[ i ] = n >= ( unsigned int )min_count ? 255 : 0;
+      }
+    } );
+  }
+
+  // getter
+  const ofFloatPixels& getHeightPixels() const { return height_pixels; }
+  const ofShortPixels& getCountPixels() const { return count_pixels; }
+  const ofPixels&      getOccupancyPixels() const { return occupancy_pixels; }
+
+  int                  getCols() const { return cols; }
+  int                  getRows() const { return rows; }
+  float                getCellSize() const { return cell_size; }
+  bool                 hasFloorPlane() const { return has_plane; }
+
+  // floor coordinates ( meters ) of a cell center
+  ofVec2f              getCellCenter( int _col, int _row ) const { return ofVec2f( area.x + ( _col + 0.5f ) * cell_size, area.y + ( _row + 0.5f ) * cell_size ); }
+
+private:
+  ofRectangle                      area;
+  float                            cell_size;
+  int                              cols, rows;
+  float                            min_height, max_height;
+  int                              min_count;
+
+  bool                             has_plane;
+  ofVec3f                          normal, right, forward;
+  float                            offset;
+
+  vector< ofVec2f >                table;
+  vector< vector< float > >        worker_heights;
+  vector< vector< unsigned int > > worker_counts;
+
+  ofFloatPixels                    height_pixels;
+  ofShortPixels                    count_pixels;
+  ofPixels                         occupancy_pixels;
+};
@@ -0,0 +1,342 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+#include "Parallel.h"
+#include "PixelConversion.h"
+#include "../ofxKinect2Enums.h"
+
+namespace ofxKinect2
+{
+  class IrProcessing;
+
+  // v * _scale + _bias, clamped to 0 - _max ( at most 32767 )
+  inline void normalizeIrRow( const unsigned short* _src, unsigned short* _dst, int _n, float _scale, float _bias, float _max )
+  {
+    int i = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128  s     = _mm_set1_ps( _scale );
+    const __m128  b     = _mm_set1_ps( _bias );
+    const __m128  fzero = _mm_setzero_ps();
+    const __m128  fmax  = _mm_set1_ps( _max );
+    for( ; i + 8 <= _n; i += 8 )
+    {
+      __m128i v  = _mm_loadu_si128( ( const __m128i* )( _src + i ) );
+      __m128  lo = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( v, zero ) ), s ), b );
+      __m128  hi = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( v, zero ) ), s ), b );
+      lo         = _mm_min_ps( _mm_max_ps( lo, fzero ), fmax );
+      hi         = _mm_min_ps( _mm_max_ps( hi, fzero ), fmax );
+      _mm_storeu_si128( ( __m128i* )( _dst + i ), _mm_packs_epi32( _mm_cvttps_epi32( lo ), _mm_cvttps_epi32( hi ) ) );
+    }
+#endif
+
+    for( ; i < _n; ++i ) _dst[ i ] = ( unsigned short )ofClamp( _src[ i ] * _scale + _bias, 0, _max );
+  }
+
+  // adds v >> _shift of a row to four interleaved sub histograms of _size bins,
+  // so that runs of equal values do not wait on the same counter
+  inline void accumulateHistogramRow( const unsigned short* _src, int _n, int _shift, unsigned int* _histogram, int _size )
+  {
+    unsigned int* h0 = _histogram;
+    unsigned int* h1 = h0 + _size;
+    unsigned int* h2 = h1 + _size;
+    unsigned int* h3 = h2 + _size;
+    int           i  = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i shift = _mm_cvtsi32_si128( _shift );
+    for( ; i + 8 <= _n; i += 8 )
+    {
+      unsigned short b[ 8 ];
+      _mm_storeu_si128( ( __m128i* )b, _mm_srl_epi16( _mm_loadu_si128( ( const __m128i* )( _src + i ) ), shift ) );
+      ++h0[ b[ 0 ] ]; ++h1[ b[ 1 ] ]; ++h2[ b[ 2 ] ]; ++h3[ b[ 3 ] ];
+      ++h0[ b[ 4 ] ]; ++h1[ b[ 5 ] ]; ++h2[ b[ 6 ] ]; ++h3[ b[ 7 ] ];
+    }
+#endif
+
+    for( ; i < _n; ++i ) ++_histogram[ ( i & 3 ) * _size + ( _src[ i ] >> _shift ) ];
+  }
+}
+
+// IrProcessing
+//   display mapping of raw infrared shared by IrStream and LongExposureIrStream.
+//   a range of raw values is mapped to 0 - 1 and, for 8 and 16 bit output, through
+//   a table indexed by the 12 bit normalized value that holds the gamma and, with
+//   IR_EXPOSURE_EQUALIZE, the equalization. the output pass also builds the
+//   histogram, which moves the range and rebuilds the table for the next frame.
+//--------------------------------------------------------------------------------
+class ofxKinect2::IrProcessing
+{
+public:
+  static const int LUT_BITS       = 12;
+  static const int LUT_SIZE       = 1 << LUT_BITS;
+  static const int HISTOGRAM_BITS = 12;
+  static const int HISTOGRAM_SIZE = 1 << HISTOGRAM_BITS;
+
+  IrProcessing()
+    : exposure( IR_EXPOSURE_FIXED )
+    , range_lo( 0 )
+    , range_hi( 65535 )
+    , active_lo( 0 )
+    , active_hi( 65535 )
+    , low_percentile( 0.01f )
+    , high_percentile( 0.99f )
+    , adaptation( 0.2f )
+    , gamma( 1 )
+    , is_normalizing_short( false )
+    , histogram( HISTOGRAM_SIZE, 0 )
+  {
+    std::fill( cdf, cdf + HISTOGRAM_SIZE + 1, 0 );
+    rebuildLut();
+  }
+
+  // raw values shown as black and white with IR_EXPOSURE_FIXED, _lo > _hi inverts.
+  // the starting point of the automatic modes, which keep the inversion
+  void setRange( float _lo, float _hi )
+  {
+    range_lo  = _lo;
+    range_hi  = _hi;
+    active_lo = _lo;
+    active_hi = _hi;
+    rebuildLut();
+  }
+
+  // out = in ^ ( 1 / _gamma ), above 1 brightens the dark end
+  void setGamma( float _gamma )
+  {
+    gamma = max( _gamma, 0.01f );
+    rebuildLut();
+  }
+
+  // the automatic modes map the _low / _high percentiles of the histogram to black
+  // and white and move there by _adaptation ( 0 - 1 ) of the distance per frame
+  void setExposure( IrExposure _exposure, float _low = 0.01f, float _high = 0.99f, float _adaptation = 0.2f )
+  {
+    exposure        = _exposure;
+    low_percentile  = ofClamp( _low, 0, 1 );
+    high_percentile = ofClamp( _high, low_percentile, 1 );
+    adaptation      = ofClamp( _adaptation, 0.01f, 1 );
+    active_lo       = range_lo;
+    active_hi       = range_hi;
+    rebuildLut();
+  }
+
+  // GRAY16 output through range and table instead of the raw values
+  void setNormalizeShort( bool _normalize ){ is_normalizing_short = _normalize; }
+
+  // getter
+  inline IrExposure     getExposure() const { return exposure; }
+  inline float          getRangeLow() const { return active_lo; }
+  inline float          getRangeHigh() const { return active_hi; }
+  inline float          getGamma() const { return gamma; }
+  inline bool           isNormalizingShort() const { return is_normalizing_short; }
+  inline bool           isLinear() const { return gamma == 1 && exposure != IR_EXPOSURE_EQUALIZE; }
+  const unsigned char*  getLut() const { return lut; }
+
+  // bins of 16 raw values of the last analyzed frame, not updated with IR_EXPOSURE_FIXED
+  const vector< unsigned int >& getHistogram() const { return histogram; }
+
+  // range and table to 8 bit, _k x _k box filtered
+  void convertToByte( const unsigned short* _src, unsigned char* _dst, int _width, int _height, int _k )
+  {
+    if( isLinear() && exposure == IR_EXPOSURE_FIXED )
+    {
+      convertShortToByte( _src, _dst, _width, _height, _k, true, active_lo, active_hi );
+      return;
+    }
+    map( _src, _dst, _width, _height, _k, lut );
+  }
+
+  // range and table to 16 bit, _k x _k box filtered
+  void convertToShort( const unsigned short* _src, unsigned short* _dst, int _width, int _height, int _k )
+  {
+    map( _src, _dst, _width, _height, _k, lut16 );
+  }
+
+  // range to 0 - 1, linear, _k x _k box filtered
+  void convertToFloat( const unsigned short* _src, float* _dst, int _width, int _height, int _k )
+  {
+    const int   ow    = _width / _k;
+    const int   oh    = _height / _k;
+    const float scale = active_hi != active_lo ? 1.f / ( active_hi - active_lo ) : 0;
+    const float bias  = -active_lo * scale;
+
+    if( active_lo == 0 && active_hi == 65535 )
+    {
+      convertShortToFloat( _src, _dst, _width, _height, _k, true, scale );
+    }
+    else
+    {
+      parallelFor( 0, oh, [ & ]( int _oy )
+      {
+        float* d = _dst + _oy * ow;
+        for( int ox = 0; ox < ow; ++ox ) d[ ox ] = ofClamp( sampleBlock( _src, _width, ox, _oy, _k, true ) * scale + bias, 0, 1 );
+      } );
+    }
+
+    if( exposure == IR_EXPOSURE_FIXED ) return;
+
+    // histogram only
+    const int chunks = beginHistogram( _height );
+    parallelFor( 0, chunks, [ & ]( int _c )
+    {
+      unsigned int* h = &chunk_histograms[ _c * 4 * HISTOGRAM_SIZE ];
+      for( int y = _height * _c / chunks; y < _height * ( _c + 1 ) / chunks; ++y )
+      {
+        accumulateHistogramRow( _src + y * _width, _width, 16 - HISTOGRAM_BITS, h, HISTOGRAM_SIZE );
+      }
+    } );
+    endHistogram( chunks );
+  }
+
+private:
+  // one pass: normalize, look up and, in the automatic modes, count
+  template< class T >
+  void map( const unsigned short* _src, T* _dst, int _width, int _height, int _k, const T* _lut )
+  {
+    const int   ow      = _width / _k;
+    const int   oh      = _height / _k;
+    const float max_v   = LUT_SIZE - 1;
+    const float scale   = active_hi != active_lo ? max_v / ( active_hi - active_lo ) : 0;
+    const float bias    = -active_lo * scale + 0.5f;
+    const bool  analyze = exposure != IR_EXPOSURE_FIXED;
+    const int   shift   = 16 - HISTOGRAM_BITS;
+    const int   chunks  = analyze ? beginHistogram( oh ) : max( min( getNumWorkers(), oh ), 1 );
+
+    parallelFor( 0, chunks, [ & ]( int _c )
+    {
+      unsigned int*  h = analyze ? &chunk_histograms[ _c * 4 * HISTOGRAM_SIZE ] : nullptr;
+      unsigned short v[ 256 ];
+
+      for( int oy = oh * _c / chunks; oy < oh * ( _c + 1 ) / chunks; ++oy )
+      {
+        T* d = _dst + oy * ow;
+        if( _k == 1 )
+        {
+          const unsigned short* s = _src + oy * _width;
+          for( int x = 0; x < ow; x += 256 )
+          {
+            const int n = min( 256, ow - x );
+            normalizeIrRow( s + x, v, n, scale, bias, max_v );
+            for( int i = 0; i < n; ++i ) d[ x + i ] = _lut[ v[ i ] ];
+          }
+          if( h ) accumulateHistogramRow( s, ow, shift, h, HISTOGRAM_SIZE );
+          continue;
+        }
+
+        for( int ox = 0; ox < ow; ++ox )
+        {
+          unsigned int b = sampleBlock( _src, _width, ox, oy, _k, true );
+          d[ ox ]        = _lut[ ( int )ofClamp( b * scale + bias, 0, max_v ) ];
+          if( h ) ++h[ ( ox & 3 ) * HISTOGRAM_SIZE + ( b >> shift ) ];
+        }
+      }
+    } );
+
+    if( analyze ) endHistogram( chunks );
+  }
+
+  // one histogram of four sub histograms per worker
+  int beginHistogram( int _rows )
+  {
+    const int chunks = max( min( getNumWorkers(), _rows ), 1 );
+    chunk_histograms.assign( chunks * 4 * HISTOGRAM_SIZE, 0 );
+    return chunks;
+  }
+
+  void endHistogram( int _chunks )
+  {
+    const int n = _chunks * 4;
+    for( int i = 0; i < HISTOGRAM_SIZE; ++i )
+    {
+      unsigned int sum = 0;
+      for( int c = 0; c < n; ++c ) sum += chunk_histograms[ c * HISTOGRAM_SIZE + i ];
+      histogram[ i ] = sum;
+    }
+    adapt();
+  }
+
+  // percentiles to the range, equalization to the table
+  void adapt()
+  {
+    unsigned int total = 0;
+    for( int i = 0; i < HISTOGRAM_SIZE; ++i )
+    {
+      cdf[ i ] = total;
+      total   += histogram[ i ];
+    }
+    cdf[ HISTOGRAM_SIZE ] = total;
+    if( total == 0 ) return;
+
+    const float  width   = 65536.f / HISTOGRAM_SIZE;
+    const double lo_rank = total * ( double )low_percentile;
+    const double hi_rank = total * ( double )high_percentile;
+    int          lo_bin  = 0;
+    int          hi_bin  = HISTOGRAM_SIZE - 1;
+    while( lo_bin < HISTOGRAM_SIZE - 1 && cdf[ lo_bin + 1 ] <= lo_rank ) ++lo_bin;
+    while( hi_bin > lo_bin && cdf[ hi_bin ] >= hi_rank ) --hi_bin;
+
+    // an inverted range stays inverted, the bright end goes to black
+    const bool  is_inverted = range_lo > range_hi;
+    const float target_lo   = lo_bin * width;
+    const float target_hi   = ( hi_bin + 1 ) * width;
+    active_lo += ( ( is_inverted ? target_hi : target_lo ) - active_lo ) * adaptation;
+    active_hi += ( ( is_inverted ? target_lo : target_hi ) - active_hi ) * adaptation;
+    if( fabs( active_hi - active_lo ) < width ) active_hi = active_lo + ( is_inverted ? -width : width );
+
+    if( exposure == IR_EXPOSURE_EQUALIZE ) buildLut( cdf );
+  }
+
+  // equalization keeps using the last analyzed frame until the next one
+  void rebuildLut()
+  {
+    buildLut( exposure == IR_EXPOSURE_EQUALIZE && cdf[ HISTOGRAM_SIZE ] > 0 ? cdf : nullptr );
+  }
+
+  // gamma over the normalized value, or over its rank in _cdf within the range
+  void buildLut( const unsigned int* _cdf )
+  {
+    float c_lo = 0;
+    float c_hi = 1;
+    if( _cdf )
+    {
+      c_lo = cdfAt( _cdf, active_lo );
+      c_hi = cdfAt( _cdf, active_hi );
+      if( fabs( c_hi - c_lo ) < 1 ) c_hi = c_lo + ( active_hi < active_lo ? -1 : 1 );
+    }
+
+    for( int i = 0; i < LUT_SIZE; ++i )
+    {
+      float t = i / ( float )( LUT_SIZE - 1 );
+      if( _cdf ) t = ofClamp( ( cdfAt( _cdf, ofLerp( active_lo, active_hi, t ) ) - c_lo ) / ( c_hi - c_lo ), 0, 1 );
+      if( gamma != 1 ) t = pow( t, 1 / gamma );
+
+      lut[ i ]   = ( unsigned char )( 255 * t + 0.5f );
+      lut16[ i ] = ( unsigned short )( 65535 * t + 0.5f );
+    }
+  }
+
+  // samples below _value, linear within the bin
+  static float cdfAt( const unsigned int* _cdf, float _value )
+  {
+    const float b = ofClamp( _value * HISTOGRAM_SIZE / 65536.f, 0, HISTOGRAM_SIZE - 0.001f );
+    const int   i = ( int )b;
+    return _cdf[ i ] + ( _cdf[ i + 1 ] - _cdf[ i ] ) * ( b - i );
+  }
+
+  IrExposure             exposure;
+  float                  range_lo, range_hi;
+  float                  active_lo, active_hi;
+  float                  low_percentile, high_percentile;
+  float                  adaptation;
+  float                  gamma;
+  bool                   is_normalizing_short;
+
+  unsigned char          lut[ LUT_SIZE ];
+  unsigned short         lut16[ LUT_SIZE ];
+  vector< unsigned int > histogram;
+  vector< unsigned int > chunk_histograms;
+  unsigned int           cdf[ HISTOGRAM_SIZE + 1 ];
+};
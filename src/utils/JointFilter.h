@@ -0,0 +1,216 @@
+#pragma once
+
+#include "ofMain.h"
+#include "../ofxKinect2Enums.h"
+
+namespace ofxKinect2
+{
+  // Holt double exponential, same parameters as the Kinect v1 TransformSmoothParameters
+  struct DoubleExponentialParams
+  {
+    DoubleExponentialParams()
+      : smoothing( 0.5f )
+      , correction( 0.5f )
+      , prediction( 0.5f )
+      , jitter_radius( 0.05f )
+      , max_deviation_radius( 0.04f )
+    {
+    }
+
+    float smoothing;
+    float correction;
+    float prediction;
+    float jitter_radius;        // meters
+    float max_deviation_radius; // meters
+  };
+
+  struct OneEuroParams
+  {
+    OneEuroParams()
+      : min_cutoff( 1.f )
+      , beta( 0.5f )
+      , d_cutoff( 1.f )
+    {
+    }
+
+    float min_cutoff; // Hz
+    float beta;
+    float d_cutoff;   // Hz
+  };
+
+  template< int Size >
+  class JointFilter;
+}
+
+// JointFilter
+//   per joint smoothing over Size joints, the state is stored as structure of arrays
+//   so each step is a flat loop over every joint of every body.
+//--------------------------------------------------------------------------------
+template< int Size >
+class ofxKinect2::JointFilter
+{
+public:
+  JointFilter()
+    : type( JOINT_FILTER_NONE )
+  {
+    reset();
+  }
+
+  void setType( JointFilterType _type ){ type = _type; reset(); }
+  void setParams( const DoubleExponentialParams& _params ){ double_exponential = _params; }
+  void setParams( const OneEuroParams& _params ){ one_euro = _params; }
+
+  JointFilterType                getType() const { return type; }
+  const DoubleExponentialParams& getDoubleExponentialParams() const { return double_exponential; }
+  const OneEuroParams&           getOneEuroParams() const { return one_euro; }
+
+  void reset(){ reset( 0, Size ); }
+  void reset( int _begin, int _end )
+  {
+    for( int i = _begin; i < _end; ++i ) frame_count[ i ] = 0;
+  }
+
+  // input, invalid joints restart their filter
+  void set( int _i, float _x, float _y, float _z, bool _valid )
+  {
+    raw[ 0 ][ _i ] = _x;
+    raw[ 1 ][ _i ] = _y;
+    raw[ 2 ][ _i ] = _z;
+    valid[ _i ]    = _valid;
+  }
+
+  // output
+  float get( int _i, int _axis ) const { return out[ _axis ][ _i ]; }
+
+  // _dt is the time since the previous frame in seconds
+  void apply( float _dt )
+  {
+    for( int i = 0; i < Size; ++i )
+    {
+      if( !valid[ i ] ) frame_count[ i ] = 0;
+    }
+
+    switch( type )
+    {
+    case JOINT_FILTER_DOUBLE_EXPONENTIAL: applyDoubleExponential(); break;
+    case JOINT_FILTER_ONE_EURO:           applyOneEuro( _dt );      break;
+    default:
+      for( int a = 0; a < 3; ++a ) std::copy( raw[ a ], raw[ a ] + Size, out[ a ] );
+      break;
+    }
+
+    for( int i = 0; i < Size; ++i )
+    {
+      frame_count[ i ] = valid[ i ] ? min( frame_count[ i ] + 1, 2 ) : 0;
+    }
+  }
+
+private:
+  void applyDoubleExponential()
+  {
+    const DoubleExponentialParams& p          = double_exponential;
+    const bool                     is_jitter  = p.jitter_radius > 0;
+    const float                    inv_jitter = is_jitter ? 1.f / p.jitter_radius : 0;
+
+    for( int i = 0; i < Size; ++i )
+    {
+      float x = raw[ 0 ][ i ], y = raw[ 1 ][ i ], z = raw[ 2 ][ i ];
+      float fx, fy, fz, tx, ty, tz;
+
+      if( frame_count[ i ] == 0 )
+      {
+        fx = x; fy = y; fz = z;
+        tx = ty = tz = 0;
+      }
+      else if( frame_count[ i ] == 1 )
+      {
+        fx = ( x + prev_raw[ 0 ][ i ] ) * 0.5f;
+        fy = ( y + prev_raw[ 1 ][ i ] ) * 0.5f;
+        fz = ( z + prev_raw[ 2 ][ i ] ) * 0.5f;
+        tx = ( fx - filtered[ 0 ][ i ] ) * p.correction + trend[ 0 ][ i ] * ( 1 - p.correction );
+        ty = ( fy - filtered[ 1 ][ i ] ) * p.correction + trend[ 1 ][ i ] * ( 1 - p.correction );
+        tz = ( fz - filtered[ 2 ][ i ] ) * p.correction + trend[ 2 ][ i ] * ( 1 - p.correction );
+      }
+      else
+      {
+        // pull samples inside the jitter radius towards the last estimate, a zero radius passes them through
+        float dx = x - filtered[ 0 ][ i ], dy = y - filtered[ 1 ][ i ], dz = z - filtered[ 2 ][ i ];
+        float w  = is_jitter ? min( sqrt( dx * dx + dy * dy + dz * dz ) * inv_jitter, 1.f ) : 1.f;
+        x = filtered[ 0 ][ i ] + dx * w;
+        y = filtered[ 1 ][ i ] + dy * w;
+        z = filtered[ 2 ][ i ] + dz * w;
+
+        fx = x * ( 1 - p.smoothing ) + ( filtered[ 0 ][ i ] + trend[ 0 ][ i ] ) * p.smoothing;
+        fy = y * ( 1 - p.smoothing ) + ( filtered[ 1 ][ i ] + trend[ 1 ][ i ] ) * p.smoothing;
+        fz = z * ( 1 - p.smoothing ) + ( filtered[ 2 ][ i ] + trend[ 2 ][ i ] ) * p.smoothing;
+        tx = ( fx - filtered[ 0 ][ i ] ) * p.correction + trend[ 0 ][ i ] * ( 1 - p.correction );
+        ty = ( fy - filtered[ 1 ][ i ] ) * p.correction + trend[ 1 ][ i ] * ( 1 - p.correction );
+        tz = ( fz - filtered[ 2 ][ i ] ) * p.correction + trend[ 2 ][ i ] * ( 1 - p.correction );
+      }
+
+      float px = fx + tx * p.prediction;
+      float py = fy + ty * p.prediction;
+      float pz = fz + tz * p.prediction;
+
+      // keep the prediction within max_deviation_radius of the raw sample
+      float ex  = px - raw[ 0 ][ i ], ey = py - raw[ 1 ][ i ], ez = pz - raw[ 2 ][ i ];
+      float len = sqrt( ex * ex + ey * ey + ez * ez );
+      float k   = len > p.max_deviation_radius ? p.max_deviation_radius / len : 1.f;
+
+      out[ 0 ][ i ] = raw[ 0 ][ i ] + ex * k;
+      out[ 1 ][ i ] = raw[ 1 ][ i ] + ey * k;
+      out[ 2 ][ i ] = raw[ 2 ][ i ] + ez * k;
+
+      prev_raw[ 0 ][ i ] = raw[ 0 ][ i ]; prev_raw[ 1 ][ i ] = raw[ 1 ][ i ]; prev_raw[ 2 ][ i ] = raw[ 2 ][ i ];
+      filtered[ 0 ][ i ] = fx;            filtered[ 1 ][ i ] = fy;            filtered[ 2 ][ i ] = fz;
+      trend[ 0 ][ i ]    = tx;            trend[ 1 ][ i ]    = ty;            trend[ 2 ][ i ]    = tz;
+    }
+  }
+
+  static float alpha( float _cutoff, float _dt )
+  {
+    float tau = 1.f / ( 2.f * PI * _cutoff );
+    return 1.f / ( 1.f + tau / _dt );
+  }
+
+  // each axis is filtered independently
+  void applyOneEuro( float _dt )
+  {
+    const OneEuroParams& p       = one_euro;
+    const float          dt      = _dt > 0 ? _dt : 1.f / 30.f;
+    const float          alpha_d = alpha( p.d_cutoff, dt );
+
+    for( int a = 0; a < 3; ++a )
+    {
+      const float* x  = raw[ a ];
+      float*       f  = filtered[ a ];
+      float*       dx = trend[ a ];
+      float*       o  = out[ a ];
+
+      for( int i = 0; i < Size; ++i )
+      {
+        bool  first = frame_count[ i ] == 0;
+        float d     = first ? 0 : ( x[ i ] - f[ i ] ) / dt;
+        float ed    = first ? 0 : dx[ i ] + alpha_d * ( d - dx[ i ] );
+
+        float a_x   = alpha( p.min_cutoff + p.beta * fabs( ed ), dt );
+
+        f[ i ]  = first ? x[ i ] : f[ i ] + a_x * ( x[ i ] - f[ i ] );
+        dx[ i ] = ed;
+        o[ i ]  = f[ i ];
+      }
+    }
+  }
+
+  JointFilterType         type;
+  DoubleExponentialParams double_exponential;
+  OneEuroParams           one_euro;
+
+  float                   raw[ 3 ][ Size ];
+  float                   prev_raw[ 3 ][ Size ];
+  float                   filtered[ 3 ][ Size ];
+  float                   trend[ 3 ][ Size ];
+  float                   out[ 3 ][ Size ];
+  bool                    valid[ Size ];
+  int                     frame_count[ Size ];
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Kinect.h"
+
+namespace ofxKinect2
+{
+  class JointHistory;
+}
+
+// JointHistory
+//   ring of the last N frames per body slot with joint positions, velocities
+//   and accelerations ( m, m/s, m/s^2 ). storage is allocated in setup() only.
+//   not thread safe, BodyStream::getHistory() copies a window of it under the stream lock.
+//--------------------------------------------------------------------------------
+class ofxKinect2::JointHistory
+{
+public:
+  JointHistory()
+    : capacity( 0 )
+  {
+    setup( 0 );
+  }
+
+  void setup( int _capacity )
+  {
+    capacity = max( _capacity, 0 );
+    for( auto& s : slots )
+    {
+      for( int a = 0; a < 3; ++a )
+      {
+        s.position[ a ].assign( capacity * JointType_Count, 0 );
+        s.velocity[ a ].assign( capacity * JointType_Count, 0 );
+        s.acceleration[ a ].assign( capacity * JointType_Count, 0 );
+      }
+      s.timestamps.assign( capacity, 0 );
+      s.id    = 0;
+      s.head  = 0;
+      s.count = 0;
+    }
+  }
+
+  // the latest _num_frames of _other, all when 0. reallocates only when the capacity changes
+  void copyLatest( const JointHistory& _other, int _num_frames = 0 )
+  {
+    int n = _num_frames > 0 ? min( _num_frames, _other.capacity ) : _other.capacity;
+    if( capacity != n ) setup( n );
+
+    for( int b = 0; b < BODY_COUNT; ++b )
+    {
+      const Slot& src   = _other.slots[ b ];
+      Slot&       dst   = slots[ b ];
+      int         count = min( src.count, n );
+
+      // oldest first, the latest frame ends up at count - 1
+      for( int f = 0; f < count; ++f )
+      {
+        int from = ( src.head - ( count - 1 - f ) + _other.capacity ) % _other.capacity;
+        for( int a = 0; a < 3; ++a )
+        {
+          std::copy_n( &src.position[ a ][ from * JointType_Count ], ( int )JointType_Count, &dst.position[ a ][ f * JointType_Count ] );
+          std::copy_n( &src.velocity[ a ][ from * JointType_Count ], ( int )JointType_Count, &dst.velocity[ a ][ f * JointType_Count ] );
+          std::copy_n( &src.acceleration[ a ][ from * JointType_Count ], ( int )JointType_Count, &dst.acceleration[ a ][ f * JointType_Count ] );
+        }
+        dst.timestamps[ f ] = src.timestamps[ from ];
+      }
+      dst.id    = src.id;
+      dst.head  = max( count - 1, 0 );
+      dst.count = count;
+    }
+  }
+
+  void clear( int _slot )
+  {
+    slots[ _slot ].count = 0;
+    slots[ _slot ].id    = 0;
+  }
+
+  // _timestamp is kinect relative time ( 100ns )
+  void push( int _slot, UINT64 _id, UINT64 _timestamp, const Joint* _joints )
+  {
+    if( capacity == 0 ) return;
+
+    Slot& s = slots[ _slot ];
+    if( s.id != _id ) clear( _slot );
+
+    int prev = s.head;
+    int head = ( s.head + 1 ) % capacity;
+    int n    = s.count;
+
+    float dt     = n > 0 ? ( _timestamp - s.timestamps[ prev ] ) * 1e-7f : 0;
+    float inv_dt = dt > 0 ? 1.f / dt : 0;
+
+    float* p[ 3 ], * v[ 3 ], * acc[ 3 ];
+    for( int a = 0; a < 3; ++a )
+    {
+      p[ a ]   = &s.position[ a ][ head * JointType_Count ];
+      v[ a ]   = &s.velocity[ a ][ head * JointType_Count ];
+      acc[ a ] = &s.acceleration[ a ][ head * JointType_Count ];
+    }
+    for( int j = 0; j < JointType_Count; ++j )
+    {
+      p[ 0 ][ j ] = _joints[ j ].Position.X;
+      p[ 1 ][ j ] = _joints[ j ].Position.Y;
+      p[ 2 ][ j ] = _joints[ j ].Position.Z;
+    }
+
+    for( int a = 0; a < 3; ++a )
+    {
+      const float* pp = n > 0 ? &s.position[ a ][ prev * JointType_Count ] : p[ a ];
+      const float* pv = n > 1 ? &s.velocity[ a ][ prev * JointType_Count ] : nullptr;
+      for( int j = 0; j < JointType_Count; ++j )
+      {
+        v[ a ][ j ]   = ( p[ a ][ j ] - pp[ j ] ) * inv_dt;
+        acc[ a ][ j ] = pv ? ( v[ a ][ j ] - pv[ j ] ) * inv_dt : 0;
+      }
+    }
+
+    s.timestamps[ head ] = _timestamp;
+    s.id                 = _id;
+    s.head               = head;
+    s.count              = min( n + 1, capacity );
+  }
+
+  // getter
+  int     getCapacity() const { return capacity; }
+  int     getNumFrames( int _slot ) const { return slots[ _slot ].count; }
+  UINT64  getId( int _slot ) const { return slots[ _slot ].id; }
+
+  int     findSlot( UINT64 _id ) const
+  {
+    for( int i = 0; i < BODY_COUNT; ++i )
+    {
+      if( slots[ i ].count > 0 && slots[ i ].id == _id ) return i;
+    }
+    return -1;
+  }
+
+  // _frames_ago = 0 is the latest frame, 0 / zero vectors while the slot is empty
+  UINT64  getTimestamp( int _slot, int _frames_ago = 0 ) const { return isEmpty( _slot ) ? 0 : slots[ _slot ].timestamps[ index( _slot, _frames_ago ) ]; }
+  ofVec3f getPosition( int _slot, JointType _joint, int _frames_ago = 0 ) const { return sample( slots[ _slot ].position, _slot, _joint, _frames_ago ); }
+  ofVec3f getVelocity( int _slot, JointType _joint, int _frames_ago = 0 ) const { return sample( slots[ _slot ].velocity, _slot, _joint, _frames_ago ); }
+  ofVec3f getAcceleration( int _slot, JointType _joint, int _frames_ago = 0 ) const { return sample( slots[ _slot ].acceleration, _slot, _joint, _frames_ago ); }
+
+private:
+  struct Slot
+  {
+    vector< float >  position[ 3 ];
+    vector< float >  velocity[ 3 ];
+    vector< float >  acceleration[ 3 ];
+    vector< UINT64 > timestamps;
+    UINT64           id;
+    int              head, count;
+  };
+
+  bool isEmpty( int _slot ) const { return capacity == 0 || slots[ _slot ].count == 0; }
+
+  int index( int _slot, int _frames_ago ) const
+  {
+    const Slot& s = slots[ _slot ];
+    _frames_ago   = ofClamp( _frames_ago, 0, max( s.count - 1, 0 ) );
+    return ( s.head - _frames_ago + capacity ) % capacity;
+  }
+
+  ofVec3f sample( const vector< float >* _axes, int _slot, JointType _joint, int _frames_ago ) const
+  {
+    if( isEmpty( _slot ) ) return ofVec3f();
+
+    int i = index( _slot, _frames_ago ) * JointType_Count + _joint;
+    return ofVec3f( _axes[ 0 ][ i ], _axes[ 1 ][ i ], _axes[ 2 ][ i ] );
+  }
+
+  int  capacity;
+  Slot slots[ BODY_COUNT ];
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+#include "BlobFinder.h"
+#include "DoubleBuffer.h"
+
+namespace ofxKinect2
+{
+  struct Marker
+  {
+    ofVec2f  position;         // sub-pixel, ir / depth space
+    int      area;
+    float    intensity;        // mean ir above the threshold
+    float    depth;            // millimeters, 0 when no valid depth around the marker
+    ofVec3f  camera_position;  // meters, zero without depth or camera table
+    uint64_t timestamp;        // kinect relative time of the frame
+  };
+
+  class MarkerDetector;
+}
+
+// MarkerDetector
+//   finds retroreflective markers as bright blobs in the raw ir, with intensity weighted
+//   sub-pixel centroids. ir and depth share one camera, so depth is looked up directly.
+//--------------------------------------------------------------------------------
+class ofxKinect2::MarkerDetector
+{
+public:
+  MarkerDetector()
+    : width( 0 )
+    , height( 0 )
+    , threshold( 20000 )
+    , depth_radius( 2 )
+  {
+    blob_finder.setAreaRange( 2, 400 );
+  }
+
+  // raw ir level a marker pixel has to exceed
+  void setThreshold( unsigned short _threshold ){ threshold = _threshold; }
+  void setAreaRange( int _min_area, int _max_area ){ blob_finder.setAreaRange( _min_area, _max_area ); }
+  // pixels around the marker bounds searched for depth, markers saturate the depth at their center
+  void setDepthRadius( int _radius ){ depth_radius = _radius; }
+  // per pixel x / y factors of camera space at 1 meter, see Mapper::getDepthFrameToCameraSpaceTable()
+  void setCameraTable( const vector< ofVec2f >& _table ){ camera_table = _table; }
+
+  // _depth may be nullptr, it has to be the full resolution depth frame otherwise
+  void update( const unsigned short* _ir, int _width, int _height, const unsigned short* _depth, uint64_t _timestamp )
+  {
+    if( !_ir ) return;
+
+    if( _width != width || _height != height )
+    {
+      width  = _width;
+      height = _height;
+      mask.assign( width * height, 0 );
+    }
+
+    classify( _ir );
+
+    const int t = threshold;
+    blob_finder.find( mask.data(), width, height, [ & ]( int _x, int _y )
+    {
+      return ( float )( _ir[ _y * width + _x ] - t );
+    } );
+
+    vector< Marker >& cur = markers.getBackBuffer();
+    cur.clear();
+    for( auto& b : blob_finder.getBlobs() )
+    {
+      Marker m;
+      m.position        = b.centroid;
+      m.area            = b.area;
+      m.intensity       = b.weight / b.area;
+      m.depth           = _depth ? sampleDepth( b, _depth ) : 0;
+      m.camera_position = toCameraSpace( m.position, m.depth );
+      m.timestamp       = _timestamp;
+      cur.push_back( m );
+    }
+    markers.swap();
+  }
+
+  // getter
+  const vector< Marker >&        getMarkers() const { return markers.getFrontBuffer(); }
+  const vector< unsigned char >& getMask() const { return mask; }
+  unsigned short                 getThreshold() const { return threshold; }
+  bool                           hasCameraTable() const { return !camera_table.empty(); }
+
+private:
+  // mask = ir > threshold
+  void classify( const unsigned short* _ir )
+  {
+    unsigned char* dst = mask.data();
+    int            n   = width * height;
+    int            i   = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i t    = _mm_set1_epi16( ( short )threshold );
+    for( ; i + 16 <= n; i += 16 )
+    {
+      __m128i m[ 2 ];
+      for( int k = 0; k < 2; ++k )
+      {
+        __m128i v = _mm_loadu_si128( ( const __m128i* )( _ir + i + k * 8 ) );
+        m[ k ]    = _mm_cmpeq_epi16( _mm_subs_epu16( v, t ), zero );
+      }
+      _mm_storeu_si128( ( __m128i* )( dst + i ), _mm_andnot_si128( _mm_packs_epi16( m[ 0 ], m[ 1 ] ), _mm_set1_epi8( -1 ) ) );
+    }
+#endif
+
+    for( ; i < n; ++i )
+    {
+      dst[ i ] = _ir[ i ] > threshold ? 255 : 0;
+    }
+  }
+
+  // median of the valid depth inside the grown bounds
+  float sampleDepth( const Blob& _blob, const unsigned short* _depth )
+  {
+    int x0 = max( _blob.min_x - depth_radius, 0 );
+    int y0 = max( _blob.min_y - depth_radius, 0 );
+    int x1 = min( _blob.max_x + depth_radius, width - 1 );
+    int y1 = min( _blob.max_y + depth_radius, height - 1 );
+
+    depths.clear();
+    for( int y = y0; y <= y1; ++y )
+    {
+      const unsigned short* row = _depth + y * width;
+      for( int x = x0; x <= x1; ++x )
+      {
+        if( row[ x ] ) depths.push_back( row[ x ] );
+      }
+    }
+    if( depths.empty() ) return 0;
+
+    nth_element( depths.begin(), depths.begin() + depths.size() / 2, depths.end() );
+    return depths[ depths.size() / 2 ];
+  }
+
+  // bilinear lookup of the camera table at the sub-pixel position
+  ofVec3f toCameraSpace( const ofVec2f& _position, float _depth ) const
+  {
+    if( _depth <= 0 || camera_table.size() != ( size_t )( width * height ) ) return ofVec3f();
+
+    int   x  = ofClamp( ( int )_position.x, 0, width - 2 );
+    int   y  = ofClamp( ( int )_position.y, 0, height - 2 );
+    float fx = ofClamp( _position.x - x, 0, 1 );
+    float fy = ofClamp( _position.y - y, 0, 1 );
+
+    const ofVec2f* t  = &camera_table[ y * width + x ];
+    ofVec2f        xy = ( t[ 0 ] * ( 1 - fx ) + t[ 1 ] * fx ) * ( 1 - fy ) + ( t[ width ] * ( 1 - fx ) + t[ width + 1 ] * fx ) * fy;
+
+    float z = _depth * 0.001f;
+    return ofVec3f( xy.x * z, xy.y * z, z );
+  }
+
+  int                              width, height;
+  unsigned short                   threshold;
+  int                              depth_radius;
+
+  vector< unsigned char >          mask;
+  vector< unsigned short >         depths;
+  vector< ofVec2f >                camera_table;
+
+  BlobFinder                       blob_finder;
+  DoubleBuffer< vector< Marker > > markers;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// parallel loops run on OpenMP ( /openmp ) and fall back to a plain loop without it
+namespace ofxKinect2
+{
+  inline int getNumWorkers()
+  {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  template< class Func >
+  inline void parallelFor( int _begin, int _end, Func _func )
+  {
+#ifdef _OPENMP
+#pragma omp parallel for schedule( static )
+#endif
+    for( int i = _begin; i < _end; ++i )
+    {
+      _func( i );
+    }
+  }
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+#include "Parallel.h"
+#include "../ofxKinect2Enums.h"
+
+// output format kernels shared by the streams. each one reads the sensor
+// buffer once and writes the final format, downscaling by an integer
+// factor on the way: _box averages _k x _k blocks, otherwise the top left
+// sample of each block is taken ( depth and body index must not be mixed ).
+namespace ofxKinect2
+{
+  inline int getNumChannels( PixelFormat _format )
+  {
+    switch( _format )
+    {
+    case PIXEL_FORMAT_RGBA:
+    case PIXEL_FORMAT_BGRA: return 4;
+    case PIXEL_FORMAT_RGB:  return 3;
+    case PIXEL_FORMAT_YUY2: return 2;
+    default:                return 1;
+    }
+  }
+
+  // _k x _k block at ( _ox, _oy ) of a single channel image
+  inline unsigned int sampleBlock( const unsigned short* _src, int _width, int _ox, int _oy, int _k, bool _box )
+  {
+    const unsigned short* s = _src + _oy * _k * _width + _ox * _k;
+    if( !_box ) return *s;
+
+    unsigned int sum = 0;
+    for( int y = 0; y < _k; ++y, s += _width )
+    {
+      for( int x = 0; x < _k; ++x ) sum += s[ x ];
+    }
+    return sum / ( _k * _k );
+  }
+
+  // 16 bit copy / downscale
+  inline void convertShort( const unsigned short* _src, unsigned short* _dst, int _width, int _height, int _k, bool _box )
+  {
+    const int ow = _width / _k;
+    const int oh = _height / _k;
+    if( _k == 1 )
+    {
+      memcpy( _dst, _src, _width * _height * sizeof( unsigned short ) );
+      return;
+    }
+
+    parallelFor( 0, oh, [ & ]( int _oy )
+    {
+      unsigned short* d = _dst + _oy * ow;
+      for( int ox = 0; ox < ow; ++ox ) d[ ox ] = ( unsigned short )sampleBlock( _src, _width, ox, _oy, _k, _box );
+    } );
+  }
+
+  // v * _scale
+  inline void convertShortRowToFloat( const unsigned short* _src, float* _dst, int _n, float _scale )
+  {
+    int i = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128  scale = _mm_set1_ps( _scale );
+    for( ; i + 8 <= _n; i += 8 )
+    {
+      __m128i v = _mm_loadu_si128( ( const __m128i* )( _src + i ) );
+      _mm_storeu_ps( _dst + i,     _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( v, zero ) ), scale ) );
+      _mm_storeu_ps( _dst + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( v, zero ) ), scale ) );
+    }
+#endif
+
+    for( ; i < _n; ++i ) _dst[ i ] = _src[ i ] * _scale;
+  }
+
+  inline void convertShortToFloat( const unsigned short* _src, float* _dst, int _width, int _height, int _k, bool _box, float _scale )
+  {
+    const int ow = _width / _k;
+    const int oh = _height / _k;
+
+    parallelFor( 0, oh, [ & ]( int _oy )
+    {
+      float* d = _dst + _oy * ow;
+      if( _k == 1 )
+      {
+        convertShortRowToFloat( _src + _oy * _width, d, _width, _scale );
+        return;
+      }
+      for( int ox = 0; ox < ow; ++ox ) d[ ox ] = sampleBlock( _src, _width, ox, _oy, _k, _box ) * _scale;
+    } );
+  }
+
+  // _lo -> 0, _hi -> 255, clamped. _lo > _hi inverts
+  inline void convertShortRowToByte( const unsigned short* _src, unsigned char* _dst, int _n, float _lo, float _hi )
+  {
+    const float scale = _hi != _lo ? 255.f / ( _hi - _lo ) : 0;
+    const float bias  = -_lo * scale + 0.5f;
+    int         i     = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128  s     = _mm_set1_ps( scale );
+    const __m128  b     = _mm_set1_ps( bias );
+    const __m128  fzero = _mm_setzero_ps();
+    const __m128  fmax  = _mm_set1_ps( 255.f );
+    for( ; i + 16 <= _n; i += 16 )
+    {
+      __m128i v[ 2 ] = { _mm_loadu_si128( ( const __m128i* )( _src + i ) ), _mm_loadu_si128( ( const __m128i* )( _src + i + 8 ) ) };
+      __m128i w[ 2 ];
+      for( int k = 0; k < 2; ++k )
+      {
+        __m128 lo = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( v[ k ], zero ) ), s ), b );
+        __m128 hi = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( v[ k ], zero ) ), s ), b );
+        lo        = _mm_min_ps( _mm_max_ps( lo, fzero ), fmax );
+        hi        = _mm_min_ps( _mm_max_ps( hi, fzero ), fmax );
+        w[ k ]    = _mm_packs_epi32( _mm_cvttps_epi32( lo ), _mm_cvttps_epi32( hi ) );
+      }
+      _mm_storeu_si128( ( __m128i* )( _dst + i ), _mm_packus_epi16( w[ 0 ], w[ 1 ] ) );
+    }
+#endif
+
+    for( ; i < _n; ++i ) _dst[ i ] = ( unsigned char )ofClamp( _src[ i ] * scale + bias, 0, 255 );
+  }
+
+  inline void convertShortToByte( const unsigned short* _src, unsigned char* _dst, int _width, int _height, int _k, bool _box, float _lo, float _hi )
+  {
+    const int   ow    = _width / _k;
+    const int   oh    = _height / _k;
+    const float scale = _hi != _lo ? 255.f / ( _hi - _lo ) : 0;
+    const float bias  = -_lo * scale + 0.5f;
+
+    parallelFor( 0, oh, [ & ]( int _oy )
+    {
+      unsigned char* d = _dst + _oy * ow;
+      if( _k == 1 )
+      {
+        convertShortRowToByte( _src + _oy * _width, d, _width, _lo, _hi );
+        return;
+      }
+      for( int ox = 0; ox < ow; ++ox ) d[ ox ] = ( unsigned char )ofClamp( sampleBlock( _src, _width, ox, _oy, _k, _box ) * scale + bias, 0, 255 );
+    } );
+  }
+
+  // 8 bit single channel copy / downscale
+  inline void convertByte( const unsigned char* _src, unsigned char* _dst, int _width, int _height, int _k )
+  {
+    const int ow = _width / _k;
+    const int oh = _height / _k;
+    if( _k == 1 )
+    {
+      memcpy( _dst, _src, _width * _height );
+      return;
+    }
+
+    parallelFor( 0, oh, [ & ]( int _oy )
+    {
+      const unsigned char* s = _src + _oy * _k * _width;
+      unsigned char*       d = _dst + _oy * ow;
+      for( int ox = 0; ox < ow; ++ox ) d[ ox ] = s[ ox * _k ];
+    } );
+  }
+
+  // 4 channel RGBA / BGRA to any 8 bit format, box filtered
+  inline void convertRgba( const unsigned char* _src, bool _src_bgra, unsigned char* _dst, PixelFormat _format, int _width, int _height, int _k )
+  {
+    const int ow       = _width / _k;
+    const int oh       = _height / _k;
+    const int channels = getNumChannels( _format );
+    const int n        = _k * _k;
+    const int r        = _src_bgra ? 2 : 0;
+    const int b        = _src_bgra ? 0 : 2;
+
+    if( _k == 1 && _format == ( _src_bgra ? PIXEL_FORMAT_BGRA : PIXEL_FORMAT_RGBA ) )
+    {
+      memcpy( _dst, _src, _width * _height * 4 );
+      return;
+    }
+
+    parallelFor( 0, oh, [ & ]( int _oy )
+    {
+      unsigned char* d = _dst + _oy * ow * channels;
+      for( int ox = 0; ox < ow; ++ox, d += channels )
+      {
+        unsigned int sum[ 4 ] = { 0, 0, 0, 0 };
+        for( int y = 0; y < _k; ++y )
+        {
+          const unsigned char* s = _src + ( ( _oy * _k + y ) * _width + ox * _k ) * 4;
+          for( int x = 0; x < _k * 4; x += 4 )
+          {
+            sum[ 0 ] += s[ x + r ];
+            sum[ 1 ] += s[ x + 1 ];
+            sum[ 2 ] += s[ x + b ];
+            sum[ 3 ] += s[ x + 3 ];
+          }
+        }
+
+        switch( _format )
+        {
+        case PIXEL_FORMAT_GRAY:
+          d[ 0 ] = ( unsigned char )( ( 77 * sum[ 0 ] + 150 * sum[ 1 ] + 29 * sum[ 2 ] ) / ( n * 256 ) );
+          break;
+
+        case PIXEL_FORMAT_BGRA:
+          d[ 0 ] = sum[ 2 ] / n;
+          d[ 1 ] = sum[ 1 ] / n;
+          d[ 2 ] = sum[ 0 ] / n;
+          d[ 3 ] = sum[ 3 ] / n;
+          break;
+
+        default:
+          for( int c = 0; c < channels; ++c ) d[ c ] = sum[ c ] / n;
+          break;
+        }
+      }
+    } );
+  }
+}
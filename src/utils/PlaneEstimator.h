@@ -0,0 +1,254 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Parallel.h"
+
+namespace ofxKinect2
+{
+  class PlaneEstimator;
+}
+
+// PlaneEstimator
+//   RANSAC + least squares plane fit on a subsampled camera space cloud.
+//   once a plane is found each update() only re-verifies it and refines it,
+//   RANSAC runs again when the inlier ratio drops.
+//   the plane is ( nx, ny, nz, d ) with the sensor on the positive side,
+//   the same convention as BodyStream::getFloorClipPlane().
+//--------------------------------------------------------------------------------
+class ofxKinect2::PlaneEstimator
+{
+public:
+  PlaneEstimator()
+    : width( 0 )
+    , height( 0 )
+    , step( 8 )
+    , threshold( 0.02f )
+    , num_iterations( 128 )
+    , refit_ratio( 0.8f )
+    , max_angle_cos( -1.f )
+    , has_plane( false )
+    , is_refit( false )
+    , inlier_ratio( 0 )
+    , fitted_ratio( 0 )
+    , seed( 1 )
+    , num_points( 0 )
+  {
+  }
+
+  // _table is Mapper::getDepthFrameToCameraSpaceTable(), the cloud samples every _step pixels.
+  // false when the table is empty or doesn't match, it is empty until the sensor runs
+  bool setup( int _width, int _height, const vector< ofVec2f >& _table, int _step = 8 )
+  {
+    if( ( int )_table.size() != _width * _height )
+    {
+      ofLogWarning( "ofxKinect2::PlaneEstimator" ) << "Depth frame to camera space table doesn't match " << _width << "x" << _height << ".";
+      return false;
+    }
+
+    width  = _width;
+    height = _height;
+    step   = max( _step, 1 );
+
+    rays.clear();
+    ray_index.clear();
+    for( int y = step / 2; y < height; y += step )
+    {
+      for( int x = step / 2; x < width; x += step )
+      {
+        int i = y * width + x;
+        rays.push_back( _table[ i ] );
+        ray_index.push_back( i );
+      }
+    }
+    cloud.resize( rays.size() );
+    setIterations( num_iterations );
+    reset();
+    return true;
+  }
+
+  void reset(){ has_plane = false; inlier_ratio = fitted_ratio = 0; }
+
+  // inlier distance in meters
+  void setThreshold( float _threshold ){ threshold = _threshold; }
+  void setIterations( int _num_iterations )
+  {
+    num_iterations = max( _num_iterations, 1 );
+    hypotheses.resize( num_iterations );
+    scores.resize( num_iterations );
+  }
+  // refit once the inlier ratio falls below this fraction of the ratio at fit time
+  void setRefitRatio( float _refit_ratio ){ refit_ratio = _refit_ratio; }
+  // only accept planes whose normal is within _max_angle degrees of _normal, e.g. ( 0, 1, 0 ) for a floor
+  void setExpectedNormal( const ofVec3f& _normal, float _max_angle )
+  {
+    expected_normal = _normal.getNormalized();
+    max_angle_cos   = cos( ofDegToRad( _max_angle ) );
+  }
+
+  bool update( const ofShortPixels& _depth ){ return update( _depth.getData(), _depth.getWidth(), _depth.getHeight() ); }
+
+  bool update( const unsigned short* _depth, int _width, int _height )
+  {
+    is_refit = false;
+    if( !_depth || _width != width || _height != height || rays.empty() ) return has_plane;
+
+    num_points = 0;
+    for( size_t i = 0; i < rays.size(); ++i )
+    {
+      unsigned short d = _depth[ ray_index[ i ] ];
+      if( d == 0 ) continue;
+
+      float z = d * 0.001f;
+      cloud[ num_points++ ].set( rays[ i ].x * z, rays[ i ].y * z, z );
+    }
+    if( num_points < 3 ) return has_plane;
+
+    if( has_plane )
+    {
+      inlier_ratio = ( float )countInliers( plane ) / num_points;
+      if( inlier_ratio >= fitted_ratio * refit_ratio )
+      {
+        refine();
+        return true;
+      }
+    }
+
+    ransac();
+    return has_plane;
+  }
+
+  // getter
+  bool           hasPlane() const { return has_plane; }
+  bool           isRefit() const { return is_refit; }
+  const ofVec4f& getPlane() const { return plane; }
+  ofVec3f        getNormal() const { return ofVec3f( plane.x, plane.y, plane.z ); }
+  float          getInlierRatio() const { return inlier_ratio; }
+  float          getDistance( const ofVec3f& _p ) const { return plane.x * _p.x + plane.y * _p.y + plane.z * _p.z + plane.w; }
+
+private:
+  int countInliers( const ofVec4f& _plane ) const
+  {
+    int n = 0;
+    for( int i = 0; i < num_points; ++i )
+    {
+      const ofVec3f& p = cloud[ i ];
+      n += fabs( _plane.x * p.x + _plane.y * p.y + _plane.z * p.z + _plane.w ) < threshold;
+    }
+    return n;
+  }
+
+  void ransac()
+  {
+    const unsigned int frame_seed = seed++;
+
+    parallelFor( 0, num_iterations, [ & ]( int _i )
+    {
+      unsigned int s = ( frame_seed * 9781u + _i * 6271u ) | 1u;
+      auto rand_index = [ & ]()
+      {
+        s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+        return ( int )( s % num_points );
+      };
+
+      const ofVec3f& a = cloud[ rand_index() ];
+      const ofVec3f& b = cloud[ rand_index() ];
+      const ofVec3f& c = cloud[ rand_index() ];
+      ofVec3f        n = ( b - a ).getCrossed( c - a );
+
+      scores[ _i ] = 0;
+      float len = n.length();
+      if( len < 1e-6f ) return;
+      n /= len;
+
+      if( !orient( n, -n.dot( a ), hypotheses[ _i ] ) ) return;
+      scores[ _i ] = countInliers( hypotheses[ _i ] );
+    } );
+
+    int best = 0;
+    for( int i = 1; i < num_iterations; ++i )
+    {
+      if( scores[ i ] > scores[ best ] ) best = i;
+    }
+    if( scores[ best ] < 3 ) return;
+
+    plane        = hypotheses[ best ];
+    has_plane    = true;
+    is_refit     = true;
+    refine();
+    inlier_ratio = fitted_ratio = ( float )countInliers( plane ) / num_points;
+  }
+
+  // least squares on the inliers: the normal is the eigenvector of the smallest eigenvalue
+  void refine()
+  {
+    ofVec3f centroid;
+    int     n = 0;
+    for( int i = 0; i < num_points; ++i )
+    {
+      if( fabs( getDistance( cloud[ i ] ) ) < threshold )
+      {
+        centroid += cloud[ i ];
+        ++n;
+      }
+    }
+    if( n < 3 ) return;
+    centroid /= n;
+
+    float xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+    for( int i = 0; i < num_points; ++i )
+    {
+      if( fabs( getDistance( cloud[ i ] ) ) >= threshold ) continue;
+
+      ofVec3f r = cloud[ i ] - centroid;
+      xx += r.x * r.x; xy += r.x * r.y; xz += r.x * r.z;
+      yy += r.y * r.y; yz += r.y * r.z; zz += r.z * r.z;
+    }
+
+    float   det_x = yy * zz - yz * yz;
+    float   det_y = xx * zz - xz * xz;
+    float   det_z = xx * yy - xy * xy;
+    ofVec3f normal;
+    if( det_x >= det_y && det_x >= det_z )  normal.set( det_x, xz * yz - xy * zz, xy * yz - xz * yy );
+    else if( det_y >= det_z )               normal.set( xz * yz - xy * zz, det_y, xy * xz - yz * xx );
+    else                                    normal.set( xy * yz - xz * yy, xy * xz - yz * xx, det_z );
+
+    if( normal.lengthSquared() < 1e-12f ) return;
+    normal.normalize();
+
+    ofVec4f refined;
+    if( orient( normal, -normal.dot( centroid ), refined ) ) plane = refined;
+  }
+
+  // puts the sensor ( origin ) on the positive side and applies the normal constraint
+  bool orient( ofVec3f _normal, float _d, ofVec4f& _plane ) const
+  {
+    if( _d < 0 )
+    {
+      _normal = -_normal;
+      _d      = -_d;
+    }
+    if( max_angle_cos > -1.f && _normal.dot( expected_normal ) < max_angle_cos ) return false;
+
+    _plane.set( _normal.x, _normal.y, _normal.z, _d );
+    return true;
+  }
+
+  int               width, height, step;
+  float             threshold;
+  int               num_iterations;
+  float             refit_ratio;
+  ofVec3f           expected_normal;
+  float             max_angle_cos;
+
+  bool              has_plane, is_refit;
+  ofVec4f           plane;
+  float             inlier_ratio, fitted_ratio;
+  unsigned int      seed;
+
+  vector< ofVec2f > rays;
+  vector< int >     ray_index;
+  vector< ofVec3f > cloud;
+  int               num_points;
+  vector< ofVec4f > hypotheses;
+  vector< int >     scores;
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#define OFXKINECT2_USE_SSE2
+#include <emmintrin.h>
+#endif
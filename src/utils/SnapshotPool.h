@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+
+namespace ofxKinect2
+{
+  template< class T >
+  class SnapshotPool;
+}
+
+// SnapshotPool
+//   a few recycled objects for publishing immutable snapshots from one producer thread.
+//   an object is reused once the pool holds its only reference.
+//--------------------------------------------------------------------------------
+template< class T >
+class ofxKinect2::SnapshotPool
+{
+public:
+  SnapshotPool( int _size = 3 )
+  {
+    allocate( _size );
+  }
+
+  // not thread safe, objects still referenced elsewhere stay valid
+  void allocate( int _size )
+  {
+    items.resize( max( _size, 1 ) );
+    for( auto& i : items ) i = std::make_shared< T >();
+  }
+
+  // producer, an object nobody else references or a new one when all are held
+  shared_ptr< T > acquire()
+  {
+    for( auto& i : items )
+    {
+      // not published and not held, nobody can get a new reference to it
+      if( i.use_count() == 1 )
+      {
+        std::atomic_thread_fence( std::memory_order_acquire );
+        return i;
+      }
+    }
+    return std::make_shared< T >();
+  }
+
+private:
+  vector< shared_ptr< T > > items;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+
+namespace ofxKinect2
+{
+  template < typename T >
+  class SpscQueue;
+}
+
+// SpscQueue
+//   lock free ring for exactly one producer and one consumer thread.
+//   capacity is rounded up to a power of two, push fails when full.
+//--------------------------------------------------------------------------------
+template < typename T >
+class ofxKinect2::SpscQueue
+{
+public:
+  SpscQueue( size_t _capacity = 64 )
+    : head( 0 )
+    , tail( 0 )
+    , num_dropped( 0 )
+  {
+    allocate( _capacity );
+  }
+
+  // not thread safe, call before producer and consumer start
+  void allocate( size_t _capacity )
+  {
+    size_t size = 1;
+    while( size < _capacity ) size <<= 1;
+
+    items.assign( size, T() );
+    mask = size - 1;
+    head.store( 0 );
+    tail.store( 0 );
+  }
+
+  // producer
+  bool push( const T& _item )
+  {
+    size_t t = tail.load( std::memory_order_relaxed );
+    if( t - head.load( std::memory_order_acquire ) > mask )
+    {
+      ++num_dropped;
+      return false;
+    }
+
+    items[ t & mask ] = _item;
+    tail.store( t + 1, std::memory_order_release );
+    return true;
+  }
+
+  // producer, writes as many as fit and returns that count
+  size_t push( const T* _items, size_t _count )
+  {
+    size_t t    = tail.load( std::memory_order_relaxed );
+    size_t free = mask + 1 - ( t - head.load( std::memory_order_acquire ) );
+    size_t n    = min( _count, free );
+
+    for( size_t i = 0; i < n; ++i ) items[ ( t + i ) & mask ] = _items[ i ];
+    tail.store( t + n, std::memory_order_release );
+
+    num_dropped += _count - n;
+    return n;
+  }
+
+  // consumer
+  bool pop( T& _item )
+  {
+    size_t h = head.load( std::memory_order_relaxed );
+    if( h == tail.load( std::memory_order_acquire ) ) return false;
+
+    _item = items[ h & mask ];
+    head.store( h + 1, std::memory_order_release );
+    return true;
+  }
+
+  // consumer, reads up to _count and returns that count
+  size_t pop( T* _items, size_t _count )
+  {
+    size_t h = head.load( std::memory_order_relaxed );
+    size_t n = min( _count, tail.load( std::memory_order_acquire ) - h );
+
+    for( size_t i = 0; i < n; ++i ) _items[ i ] = items[ ( h + i ) & mask ];
+    head.store( h + n, std::memory_order_release );
+    return n;
+  }
+
+  // approximate from any thread other than the one changing it
+  size_t size() const { return tail.load( std::memory_order_acquire ) - head.load( std::memory_order_acquire ); }
+  size_t capacity() const { return mask + 1; }
+  size_t getNumDropped() const { return num_dropped.load( std::memory_order_relaxed ); }
+
+private:
+  vector< T >         items;
+  size_t              mask;
+
+  // producer and consumer indices on separate cache lines
+  char                pad0[ 64 ];
+  std::atomic<size_t> head;
+  char                pad1[ 64 ];
+  std::atomic<size_t> tail;
+  char                pad2[ 64 ];
+  std::atomic<size_t> num_dropped;
+};
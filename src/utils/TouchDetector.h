@@ -0,0 +1,262 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Simd.h"
+#include "BlobFinder.h"
+#include "DoubleBuffer.h"
+#include "SpscQueue.h"
+
+namespace ofxKinect2
+{
+  struct Touch
+  {
+    int      id;
+    ofVec2f  position;   // sub-pixel, depth space
+    int      area;
+    uint64_t timestamp;  // kinect relative time of the frame
+    uint64_t latency;    // micros from the frame timestamp to the event
+  };
+
+  class TouchDetector;
+}
+
+// TouchDetector
+//   learns a reference surface and reports contacts inside a height band above it.
+//   runs on the depth reader thread, events are queued for popEvent() on the consumer thread.
+//--------------------------------------------------------------------------------
+class ofxKinect2::TouchDetector
+{
+public:
+  TouchDetector()
+    : width( 0 )
+    , height( 0 )
+    , min_height( 6 )
+    , max_height( 25 )
+    , max_distance( 15 )
+    , frames_to_learn( 0 )
+    , learned_frames( 0 )
+    , next_id( 0 )
+  {
+    blob_finder.setAreaRange( 10, 400 );
+  }
+
+  enum EventType { EVENT_DOWN, EVENT_MOVED, EVENT_UP };
+
+  // averages the next _num_frames as the surface, nothing in the band should be there meanwhile
+  void learnSurface( int _num_frames = 30 ){ learned_frames = 0; frames_to_learn = _num_frames; }
+  bool isSurfaceLearned() const { return frames_to_learn == 0 && learned_frames > 0; }
+
+  // band above the surface in millimeters
+  void setHeightBand( unsigned short _min_height, unsigned short _max_height ){ min_height = _min_height; max_height = _max_height; }
+  void setAreaRange( int _min_area, int _max_area ){ blob_finder.setAreaRange( _min_area, _max_area ); }
+  // max movement ( depth pixels ) per frame to keep a touch id
+  void setMaxDistance( float _max_distance ){ max_distance = _max_distance; }
+
+  // reader thread
+  void update( const unsigned short* _depth, int _width, int _height, uint64_t _timestamp )
+  {
+    if( !_depth ) return;
+
+    if( _width != width || _height != height )
+    {
+      width  = _width;
+      height = _height;
+      surface.assign( width * height, 0 );
+      mask.getFrontBuffer().assign( width * height, 0 );
+      mask.getBackBuffer().assign( width * height, 0 );
+      learned_frames = 0;
+    }
+
+    if( frames_to_learn > 0 )
+    {
+      learn( _depth );
+      return;
+    }
+    if( learned_frames == 0 ) return;
+
+    classify( _depth );
+
+    const unsigned short* surf = surface.data();
+    blob_finder.find( mask.getBackBuffer().data(), width, height, [ & ]( int _x, int _y )
+    {
+      int i = _y * width + _x;
+      return ( float )( max_height + 1 - ( surf[ i ] - _depth[ i ] ) );
+    } );
+    mask.swap();
+
+    track( _timestamp );
+  }
+
+  // consumer thread, the next queued event. _relative_time is the current kinect relative time
+  bool popEvent( EventType& _type, Touch& _touch, uint64_t _relative_time )
+  {
+    Event e;
+    if( !events.pop( e ) ) return false;
+
+    _type          = e.type;
+    _touch         = e.touch;
+    _touch.latency = _relative_time > e.touch.timestamp ? ( _relative_time - e.touch.timestamp ) / 10 : 0;
+    return true;
+  }
+
+  // getter, published by the last update()
+  const vector< Touch >&          getTouches() const { return touches.getFrontBuffer(); }
+  const vector< unsigned char >&  getMask() const { return mask.getFrontBuffer(); }
+  const vector< unsigned short >& getSurface() const { return surface; }
+
+private:
+  struct Event
+  {
+    EventType type;
+    Touch     touch;
+  };
+
+  // a stalled consumer loses the newest events, not the reader thread
+  void pushEvent( EventType _type, const Touch& _touch )
+  {
+    Event e;
+    e.type  = _type;
+    e.touch = _touch;
+    if( !events.push( e ) ) ofLogVerbose( "ofxKinect2::TouchDetector" ) << "Touch event queue full.";
+  }
+
+  void learn( const unsigned short* _depth )
+  {
+    if( learned_frames == 0 )
+    {
+      accumulation.assign( width * height, 0 );
+      counts.assign( width * height, 0 );
+    }
+
+    for( int i = 0; i < width * height; ++i )
+    {
+      if( _depth[ i ] == 0 ) continue;
+      accumulation[ i ] += _depth[ i ];
+      ++counts[ i ];
+    }
+    ++learned_frames;
+
+    if( --frames_to_learn == 0 )
+    {
+      for( int i = 0; i < width * height; ++i )
+      {
+        surface[ i ] = counts[ i ] ? ( unsigned short )( accumulation[ i ] / counts[ i ] ) : 0;
+      }
+    }
+  }
+
+  // mask = depth valid && min <= surface - depth <= max
+  void classify( const unsigned short* _depth )
+  {
+    const unsigned short* surf = surface.data();
+    unsigned char*        dst  = mask.getBackBuffer().data();
+    int                   n    = width * height;
+    int                   i    = 0;
+
+#ifdef OFXKINECT2_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo   = _mm_set1_epi16( ( short )min_height );
+    const __m128i hi   = _mm_set1_epi16( ( short )max_height );
+    for( ; i + 16 <= n; i += 16 )
+    {
+      __m128i m[ 2 ];
+      for( int k = 0; k < 2; ++k )
+      {
+        __m128i d    = _mm_loadu_si128( ( const __m128i* )( _depth + i + k * 8 ) );
+        __m128i s    = _mm_loadu_si128( ( const __m128i* )( surf + i + k * 8 ) );
+        __m128i diff = _mm_subs_epu16( s, d );
+        __m128i ok   = _mm_and_si128( _mm_cmpeq_epi16( _mm_subs_epu16( lo, diff ), zero ),
+                                      _mm_cmpeq_epi16( _mm_subs_epu16( diff, hi ), zero ) );
+        // the saturated difference is 0 behind the surface, reject d > s, no depth and no surface
+        __m128i bad  = _mm_or_si128( _mm_cmpeq_epi16( d, zero ), _mm_cmpeq_epi16( s, zero ) );
+        bad          = _mm_or_si128( bad, _mm_xor_si128( _mm_cmpeq_epi16( _mm_subs_epu16( d, s ), zero ), _mm_set1_epi16( -1 ) ) );
+        m[ k ]       = _mm_andnot_si128( bad, ok );
+      }
+      _mm_storeu_si128( ( __m128i* )( dst + i ), _mm_packs_epi16( m[ 0 ], m[ 1 ] ) );
+    }
+#endif
+
+    for( ; i < n; ++i )
+    {
+      int diff = ( int )surf[ i ] - _depth[ i ];
+      dst[ i ] = ( _depth[ i ] && surf[ i ] && diff >= min_height && diff <= max_height ) ? 255 : 0;
+    }
+  }
+
+  // greedy nearest neighbour against the previous touches
+  void track( uint64_t _timestamp )
+  {
+    const vector< Touch >& prev  = touches.getFrontBuffer();
+    vector< Touch >&       cur   = touches.getBackBuffer();
+    const vector< Blob >&  blobs = blob_finder.getBlobs();
+
+    cur.clear();
+    matched.assign( prev.size(), false );
+    is_new.clear();
+
+    for( auto& b : blobs )
+    {
+      Touch t;
+      t.position  = b.centroid;
+      t.area      = b.area;
+      t.timestamp = _timestamp;
+      t.id        = -1;
+
+      float best_distance = max_distance * max_distance;
+      int   best          = -1;
+      for( size_t j = 0; j < prev.size(); ++j )
+      {
+        float d = prev[ j ].position.squareDistance( t.position );
+        if( !matched[ j ] && d < best_distance )
+        {
+          best_distance = d;
+          best          = j;
+        }
+      }
+
+      if( best >= 0 )
+      {
+        matched[ best ] = true;
+        t.id            = prev[ best ].id;
+      }
+      else
+      {
+        t.id = next_id++;
+      }
+      cur.push_back( t );
+      is_new.push_back( best < 0 );
+    }
+
+    for( size_t i = 0; i < cur.size(); ++i )
+    {
+      pushEvent( is_new[ i ] ? EVENT_DOWN : EVENT_MOVED, cur[ i ] );
+    }
+
+    for( size_t j = 0; j < prev.size(); ++j )
+    {
+      if( matched[ j ] ) continue;
+
+      Touch t     = prev[ j ];
+      t.timestamp = _timestamp;
+      pushEvent( EVENT_UP, t );
+    }
+
+    touches.swap();
+  }
+
+  int                                     width, height;
+  unsigned short                          min_height, max_height;
+  float                                   max_distance;
+
+  std::atomic< int >                      frames_to_learn;
+  std::atomic< int >                      learned_frames;
+  vector< unsigned int >                  accumulation, counts;
+  vector< unsigned short >                surface;
+  DoubleBuffer< vector< unsigned char > > mask;
+
+  BlobFinder                              blob_finder;
+  DoubleBuffer< vector< Touch > >         touches;
+  vector< bool >                          matched, is_new;
+  int                                     next_id;
+  SpscQueue< Event >                      events;
+};